@@ -0,0 +1,693 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+#include "phys.h"
+#include "list.h"
+#include "const.h"
+#include "narrow.h"
+
+// Headless benchmark of the simulation.
+// Runs scripted scenarios for a fixed number of steps with no window and no
+// clock deciding how much gets stepped, so two runs with the same options do
+// the same work and can be compared.
+//
+// usage: bench [options]
+//   -s scenario    spawn, sweep, pile, crowd, pegs or all (default all)
+//   -n steps       steps per scenario (default 1200)
+//   -c circles     circles per scenario (default 1000)
+//   -r rate        circles spawned per second by the spawn scenario (default 200)
+//   -b broadphase  one of the BROADPHASE_ modes (default grid)
+//   -x static      one of the STATIC_ modes (default analytic)
+//   -m mode        one of the STEP_ modes (default fixed)
+//   -o solver      one of the SOLVER_ modes (default sequential)
+//   -l schedule    one of the SCHEDULE_ modes for variable steps (default round robin),
+//                  the sweep scenario's mouse circle is the focus
+//   -t threads     threads finding contacts and running SOLVER_PARALLEL (default 1)
+//   -w work        busy loop iterations per pair test (default 0)
+//   -S             run the scenarios at 1, 2, 4 ... threads up to the core count,
+//                  or up to -t if given, then print each one's speedup over 1 thread
+//   -k             check the SSE narrow phase kernels against the scalar ones
+//                  instead of running scenarios, exits with 1 on any difference,
+//                  and time the circle vs rect kernels on their own
+//
+// Step times are wall clock, pairs and hits are narrow phase tests and the
+// contacts they found, peak KB is the most the process has held so far.
+// With -m 2 each scenario also prints the hash of its deterministic state,
+// which should not change with the thread count, broadphase or compiler flags.
+
+#define DEFAULT_STEPS 1200
+#define DEFAULT_CIRCLES 1000
+#define DEFAULT_RATE 200
+#define BENCH_SEED 0x5eed1234u
+// kernel check sizes
+#define CHECK_BODIES 2000
+#define CHECK_PAIRS 200000
+#define CHECK_RECTS 64
+// times each rect kernel runs over the check pairs when timing it
+#define CHECK_REPEATS 20
+// largest difference allowed between scalar and SSE depths and normals
+#define CHECK_EPSILON 0.001f
+
+#define MAX_STATICS 1024
+
+// thread counts -S runs at most, 1, 2, 4 ... then the top count
+#define MAX_SCALING_RUNS 16
+
+// distance between pegs in the pegs scenario
+#define PEG_SPACING 40
+
+// simulated time of one step, a frame at 60 fps
+#define STEP_DT (1.0 / 60.0)
+
+struct Scenario {
+    const char *name;
+    void (*setup)();
+    void (*step)(int step);     // runs before every physics step, 0 if nothing has to
+};
+
+void setupLevel();
+int checkRectKernel(const char *name, struct Bodies *bodies, struct Rect *rects, int num_rects, int *a, struct Manifold *scalar, struct Manifold *sse);
+void spawnCircle();
+void addRows(float left, float right, float bottom, int n, float radius);
+void setupSpawn();
+void stepSpawn(int step);
+void setupSweep();
+void stepSweep(int step);
+void setupPile();
+void setupCrowd();
+void setupPegs();
+void stepPegs(int step);
+double runScenario(struct Scenario *s);
+void runScenarios(const char *scenario, double *means);
+void runScaling(const char *scenario, int max_threads);
+int checkKernels();
+double wallTime();
+long peakMemory();
+void usage();
+
+struct Scenario scenarios[] = {
+    {"spawn", setupSpawn, stepSpawn},   // circles falling in at a steady rate over the level
+    {"sweep", setupSweep, stepSweep},   // the explosive mouse circle sweeping through a full level
+    {"pile", setupPile, 0},             // everything dropped at once into one box
+    {"crowd", setupCrowd, 0},           // the whole screen filled, circles shrink to fit any count
+    {"pegs", setupPegs, stepPegs},      // a steady stream falling through hundreds of static pegs
+};
+#define NUM_SCENARIOS (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+struct List objects;
+
+int num_steps = DEFAULT_STEPS;
+int num_circles = DEFAULT_CIRCLES;
+float spawn_rate = DEFAULT_RATE;
+
+uint32_t seed = BENCH_SEED;
+int num_spawned = 0;
+
+struct Node *mouse = 0;
+float mouse_x = 0;
+float mouse_y = 0;
+
+// everything a scenario added, removed again after it ran
+int statics[MAX_STATICS];
+int num_statics = 0;
+
+// the simulated clock phys.c reads, one STEP_DT further every step
+uint64_t sim_ticks = 0;
+
+double *step_times = 0;
+
+int main(int argc, char **argv) {
+    const char *scenario = "all";
+    int kernels = 0;
+    int scaling = 0;
+    int threads = 0;
+
+    initList(&objects);
+    initPhysics();
+    setBroadphase(BROADPHASE_GRID);
+    setStepMode(STEP_FIXED);
+    setSolver(SOLVER_SEQUENTIAL);
+    setPairWork(0);
+
+    for(int i = 1; i < argc; i ++) {
+        if(strcmp(argv[i], "-k") == 0) {
+            kernels = 1;
+            continue;
+        }
+        if(strcmp(argv[i], "-S") == 0) {
+            scaling = 1;
+            continue;
+        }
+        if(argv[i][0] != '-' || argv[i][1] == 0 || argv[i][2] != 0 || i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+
+        char *value = argv[++ i];
+        switch(argv[i - 1][1]) {
+            case 's': scenario = value; break;
+            case 'n': num_steps = atoi(value); break;
+            case 'c': num_circles = atoi(value); break;
+            case 'r': spawn_rate = atof(value); break;
+            case 'b': setBroadphase(atoi(value)); break;
+            case 'x': setStaticCollision(atoi(value)); break;
+            case 'm': setStepMode(atoi(value)); break;
+            case 'o': setSolver(atoi(value)); break;
+            case 'l': setSchedule(atoi(value)); break;
+            case 't': threads = atoi(value); break;
+            case 'w': setPairWork(atoi(value)); break;
+            default:
+                usage();
+                return 1;
+        }
+    }
+    if(num_steps <= 0 || num_circles < 0 || spawn_rate <= 0 || threads < 0) {
+        usage();
+        return 1;
+    }
+
+    if(kernels) {
+        return checkKernels();
+    }
+
+    step_times = malloc(num_steps * sizeof(double));
+    if(step_times == 0) {
+        printf("error allocating memory for step times\n");
+        exit(1);
+    }
+
+    // check the name before anything runs
+    int found = 0;
+    for(int i = 0; i < NUM_SCENARIOS; i ++) {
+        if(strcmp(scenario, "all") == 0 || strcmp(scenario, scenarios[i].name) == 0) {
+            found = 1;
+        }
+    }
+    if(!found) {
+        usage();
+        return 1;
+    }
+
+    if(scaling) {
+        runScaling(scenario, threads > 0 ? threads : getCoreCount());
+    }
+    else {
+        setPhysThreads(threads > 0 ? threads : 1);
+        runScenarios(scenario, 0);
+    }
+
+    free(step_times);
+    return 0;
+}
+
+// runs every scenario matching scenario with the current settings and prints
+// a table of them, means gets each one's mean step time in ms if it is not 0
+void runScenarios(const char *scenario, double *means) {
+    printf("%d steps, %d circles, broadphase %d, static %d, step mode %d, solver %d, threads %d\n",
+        num_steps, num_circles, getBroadphase(), getStaticCollision(), getStepMode(), getSolver(), getPhysThreads());
+    printf("%-8s %7s %7s %8s %8s %8s %8s %8s %11s %11s %10s\n", "scenario", "bodies", "asleep",
+        "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms", "pairs/step", "hits/step", "peak KB");
+
+    int n = 0;
+    for(int i = 0; i < NUM_SCENARIOS; i ++) {
+        if(strcmp(scenario, "all") != 0 && strcmp(scenario, scenarios[i].name) != 0) {
+            continue;
+        }
+        double mean = runScenario(&scenarios[i]);
+        if(means != 0) {
+            means[n] = mean;
+        }
+        n ++;
+    }
+}
+
+// runs the scenarios at 1, 2, 4 ... threads and then max_threads,
+// then prints every mean step time as a speedup over the 1 thread run
+void runScaling(const char *scenario, int max_threads) {
+    int counts[MAX_SCALING_RUNS];
+    double means[MAX_SCALING_RUNS][NUM_SCENARIOS];
+    int num_runs = 0;
+
+    for(int threads = 1; num_runs < MAX_SCALING_RUNS; threads *= 2) {
+        if(threads > max_threads) {
+            threads = max_threads;
+        }
+        counts[num_runs] = threads;
+        setPhysThreads(threads);
+        runScenarios(scenario, means[num_runs]);
+        num_runs ++;
+        printf("\n");
+
+        if(threads == max_threads) {
+            break;
+        }
+    }
+
+    printf("speedup over 1 thread, %d cores\n", getCoreCount());
+    printf("%-8s", "scenario");
+    for(int k = 0; k < num_runs; k ++) {
+        printf(" %7dt", counts[k]);
+    }
+    printf("\n");
+
+    int n = 0;
+    for(int i = 0; i < NUM_SCENARIOS; i ++) {
+        if(strcmp(scenario, "all") != 0 && strcmp(scenario, scenarios[i].name) != 0) {
+            continue;
+        }
+        printf("%-8s", scenarios[i].name);
+        for(int k = 0; k < num_runs; k ++) {
+            printf(" %7.2fx", means[0][n] / means[k][n]);
+        }
+        printf("\n");
+        n ++;
+    }
+}
+
+// phys.c reads the time through timer.h, the bench links these instead of
+// timer.c so it is the simulated clock, and every body steps exactly STEP_DT
+// however long the step really took
+int initTimer() {
+    return 0;
+}
+
+uint64_t getTicks() {
+    return sim_ticks;
+}
+
+uint64_t updateFrameTicks() {
+    return sim_ticks;
+}
+
+uint64_t getFrameTicks() {
+    return sim_ticks;
+}
+
+// the boxes of the level main.c plays in, x y length height
+float level_rects[][4] = {
+    {20, 100, 20, SCREEN_HEIGHT - 100},   // left box
+    {SCREEN_WIDTH - 40, 100, 20, SCREEN_HEIGHT - 100},   // right box
+    {150, SCREEN_HEIGHT - 100, SCREEN_WIDTH - 300, 100},   // center box
+};
+#define NUM_LEVEL_RECTS (int)(sizeof(level_rects) / sizeof(level_rects[0]))
+
+// the level main.c plays in
+void setupLevel() {
+    for(int i = 0; i < NUM_LEVEL_RECTS; i ++) {
+        statics[num_statics ++] = addRect(level_rects[i][0], level_rects[i][1], level_rects[i][2], level_rects[i][3]);
+    }
+    statics[num_statics ++] = addStaticCircle(SCREEN_WIDTH / 2, SCREEN_HEIGHT - 125, 100);   // middle circle
+    statics[num_statics ++] = addStaticCircle(SCREEN_WIDTH / 8, SCREEN_HEIGHT / 4, 75);
+    statics[num_statics ++] = addStaticCircle(7 * SCREEN_WIDTH / 8, SCREEN_HEIGHT / 4, 75);
+    statics[num_statics ++] = addStaticCircle(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 75);
+    statics[num_statics ++] = addStaticCircle(3 * SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 75);
+}
+
+// a circle where main.c's spawner would put one
+void spawnCircle() {
+    int x_var = 3 * SCREEN_WIDTH / 4;
+    int y_var = 100;
+    x_var = (int)(nextRandom(&seed) % x_var) - x_var / 2;
+    y_var = (int)(nextRandom(&seed) % y_var) - y_var / 2;
+    addCircle(&objects, SCREEN_WIDTH / 2 + x_var, 100 + y_var, 0, 0, 7.5, 1);
+    num_spawned ++;
+}
+
+// n circles packed in rows between left and right, upwards from bottom
+// slightly off a perfect grid so the rows do not stack straight up
+void addRows(float left, float right, float bottom, int n, float radius) {
+    float spacing = 2 * radius + 1;
+    int per_row = (right - left) / spacing;
+    for(int i = 0; i < n; i ++) {
+        float x = left + radius + 0.5f + (i % per_row) * spacing + (nextRandom(&seed) % 100) / 100.0f;
+        float y = bottom - radius - 0.5f - (i / per_row) * spacing;
+        addCircle(&objects, x, y, 0, 0, radius, 1);
+    }
+    num_spawned += n;
+}
+
+void setupSpawn() {
+    setupLevel();
+}
+
+// circles the spawn rate has asked for by the end of step
+int spawnsDue(int step) {
+    return (step + 1) * spawn_rate * STEP_DT;
+}
+
+void stepSpawn(int step) {
+    while(num_spawned < spawnsDue(step) && num_spawned < num_circles) {
+        spawnCircle();
+    }
+}
+
+void setupSweep() {
+    setupLevel();
+    addRows(60, SCREEN_WIDTH - 60, SCREEN_HEIGHT / 2, num_circles, 7.5);
+
+    mouse_x = 100;
+    mouse_y = SCREEN_HEIGHT / 2 - 150;
+    mouse = addCircle(&objects, mouse_x, mouse_y, 0, 0, 20, 0);
+    setCircleExplosive(mouse, 1);
+    setFocusCircle(mouse);
+}
+
+// 0 to range and back over period steps, in whole pixels so the path is the
+// same whatever the compiler makes of float expressions
+int triangle(int step, int period, int range) {
+    int t = step % period * 2;
+    return (t < period ? t : 2 * period - t) * range / period;
+}
+
+// back and forth across the level once a second, bobbing up and down
+// starts where setupSweep put it
+void stepSweep(int step) {
+    float x = 100 + triangle(step, 60, SCREEN_WIDTH - 200);
+    float y = SCREEN_HEIGHT / 2 - 150 + triangle(step, 20, 300);
+    translateCircle(mouse, x - mouse_x, y - mouse_y);
+    mouse_x = x;
+    mouse_y = y;
+}
+
+// a closed box, everything starts packed above its floor
+void setupPile() {
+    float left = 200;
+    float right = SCREEN_WIDTH - 200;
+    float floor = SCREEN_HEIGHT - 60;
+    statics[num_statics ++] = addRect(left - 20, 0, 20, SCREEN_HEIGHT);
+    statics[num_statics ++] = addRect(right, 0, 20, SCREEN_HEIGHT);
+    statics[num_statics ++] = addRect(left - 20, floor, right - left + 40, 20);
+
+    addRows(left, right, floor, num_circles, 7.5);
+}
+
+// a closed box as big as the screen, filled up to near its top
+// circles are as big as main.c's up to where that many no longer fit,
+// then shrink, so large counts still start on screen
+void setupCrowd() {
+    float left = 20;
+    float right = SCREEN_WIDTH - 20;
+    float floor = SCREEN_HEIGHT - 20;
+    statics[num_statics ++] = addRect(0, 0, left, SCREEN_HEIGHT);
+    statics[num_statics ++] = addRect(right, 0, 20, SCREEN_HEIGHT);
+    statics[num_statics ++] = addRect(left, floor, right - left, 20);
+
+    float radius = 7.5;
+    if(num_circles > 0) {
+        float spacing = sqrtf((right - left) * (floor - 100) / num_circles);
+        if((spacing - 1) / 2 < radius) {
+            radius = (spacing - 1) / 2;
+        }
+    }
+    addRows(left, right, floor, num_circles, radius);
+}
+
+// staggered rows of small circles and rects below the spawn area,
+// open at the bottom so the stream drains off the screen
+void setupPegs() {
+    statics[num_statics ++] = addRect(0, 0, 20, SCREEN_HEIGHT);
+    statics[num_statics ++] = addRect(SCREEN_WIDTH - 20, 0, 20, SCREEN_HEIGHT);
+
+    int row = 0;
+    for(float y = 200; y < SCREEN_HEIGHT - 40; y += PEG_SPACING, row ++) {
+        float x = row % 2 ? 40 + PEG_SPACING / 2 : 40;
+        for(; x < SCREEN_WIDTH - 40 && num_statics < MAX_STATICS; x += PEG_SPACING) {
+            if(row % 2) {
+                statics[num_statics ++] = addStaticCircle(x, y, 5);
+            }
+            else {
+                statics[num_statics ++] = addRect(x - 6, y - 3, 12, 6);
+            }
+        }
+    }
+}
+
+// spawns at the spawn rate, topping up to the circle count as circles drain
+void stepPegs(int step) {
+    while(num_spawned < spawnsDue(step) && objects.length < num_circles) {
+        spawnCircle();
+    }
+}
+
+static int compareTimes(const void *a, const void *b) {
+    double x = *(double *)a;
+    double y = *(double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// step time at fraction p of the sorted step times, in milliseconds
+float percentileMs(float p) {
+    return step_times[(int)((num_steps - 1) * p)] * 1000;
+}
+
+// runs s and prints its row, returns the mean step time in ms
+double runScenario(struct Scenario *s) {
+    struct PhysStats stats;
+
+    seed = BENCH_SEED;
+    num_spawned = 0;
+    mouse = 0;
+    s->setup();
+
+    // throw away whatever setting up counted
+    getPhysStats(&stats);
+
+    double total = 0;
+    for(int i = 0; i < num_steps; i ++) {
+        if(s->step != 0) {
+            s->step(i);
+        }
+        sim_ticks += secondsToTicks(STEP_DT);
+
+        double start = wallTime();
+        if(getStepMode() != STEP_VARIABLE) {
+            stepPhysics(&objects);
+        }
+        else {
+            updatePhysics(&objects, STEP_DT);
+        }
+        step_times[i] = wallTime() - start;
+        total += step_times[i];
+    }
+    getPhysStats(&stats);
+
+    int bodies = objects.length;
+
+    qsort(step_times, num_steps, sizeof(double), compareTimes);
+    printf("%-8s %7d %7lu %8.3f %8.3f %8.3f %8.3f %8.3f %11.0f %11.0f %10ld\n", s->name, bodies, stats.sleeping,
+        total * 1000 / num_steps, percentileMs(0.5f), percentileMs(0.9f), percentileMs(0.99f),
+        percentileMs(1.0f), (float)stats.pair_tests / num_steps, (float)stats.contacts / num_steps, peakMemory());
+    double mean = total * 1000 / num_steps;
+    if(getStepMode() == STEP_DETERMINISTIC) {
+        printf("%-8s hash %08x\n", s->name, hashPhysState());
+    }
+
+    clearObjects(&objects);
+    for(int i = 0; i < num_statics; i ++) {
+        removeStatic(statics[i]);
+    }
+    num_statics = 0;
+
+    return mean;
+}
+
+// 1 if the contacts match within CHECK_EPSILON, otherwise prints the first difference
+int sameContacts(const char *kernel, struct Manifold *scalar, int num_scalar, struct Manifold *sse, int num_sse) {
+    if(num_scalar != num_sse) {
+        printf("%s: MISMATCH, scalar found %d contacts, sse %d\n", kernel, num_scalar, num_sse);
+        return 0;
+    }
+
+    for(int k = 0; k < num_scalar; k ++) {
+        struct Manifold *x = &scalar[k];
+        struct Manifold *y = &sse[k];
+        if(x->a != y->a || x->b != y->b
+            || fabsf(x->penetration - y->penetration) > CHECK_EPSILON
+            || fabsf(x->norm.x - y->norm.x) > CHECK_EPSILON
+            || fabsf(x->norm.y - y->norm.y) > CHECK_EPSILON) {
+            printf("%s: MISMATCH at contact %d\n", kernel, k);
+            printf("  scalar: %d %d depth %f normal %f %f\n",
+                x->a, x->b, x->penetration, x->norm.x, x->norm.y);
+            printf("  sse:    %d %d depth %f normal %f %f\n",
+                y->a, y->b, y->penetration, y->norm.x, y->norm.y);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// random value in [0, range) with hundredths
+float randomCoord(int range) {
+    return (nextRandom(&seed) % (range * 100)) / 100.0f;
+}
+
+// runs the scalar and SSE kernels over the same random circles
+// and compares hits, depths and normals, returns 0 if they all match
+int checkKernels() {
+    struct Bodies bodies;
+    initBodies(&bodies);
+    seed = BENCH_SEED;
+    int failed = 0;
+
+    // circles against circles, one in five static
+    for(int i = 0; i < CHECK_BODIES; i ++) {
+        int k = addBody(&bodies);
+        bodies.pos_x[k] = randomCoord(400);
+        bodies.pos_y[k] = randomCoord(400);
+        bodies.radius[k] = 2 + nextRandom(&seed) % 10;
+        bodies.inv_mass[k] = nextRandom(&seed) % 5 ? 1 : 0;
+    }
+    // one pair directly on top of eachother
+    bodies.pos_x[1] = bodies.pos_x[0];
+    bodies.pos_y[1] = bodies.pos_y[0];
+    bodies.inv_mass[0] = 1;
+
+    int *a = malloc(CHECK_PAIRS * sizeof(int));
+    int *b = malloc(CHECK_PAIRS * sizeof(int));
+    struct Manifold *scalar = malloc(CHECK_PAIRS * sizeof(struct Manifold));
+    struct Manifold *sse = malloc(CHECK_PAIRS * sizeof(struct Manifold));
+    if(a == 0 || b == 0 || scalar == 0 || sse == 0) {
+        printf("error allocating memory for kernel check\n");
+        exit(1);
+    }
+    for(int k = 0; k < CHECK_PAIRS; k ++) {
+        a[k] = nextRandom(&seed) % CHECK_BODIES;
+        b[k] = nextRandom(&seed) % CHECK_BODIES;
+    }
+    a[5] = 0;
+    b[5] = 1;
+
+    int num_scalar = narrowCircCircScalar(&bodies, a, b, CHECK_PAIRS, scalar);
+    int num_sse = narrowCircCirc(&bodies, a, b, CHECK_PAIRS, sse);
+    if(sameContacts("circle vs circle", scalar, num_scalar, sse, num_sse)) {
+        printf("circle vs circle: %d pairs, %d contacts, match\n", CHECK_PAIRS, num_scalar);
+    }
+    else {
+        failed = 1;
+    }
+
+    // circles against rects, the kernel takes the bodies of one rect at a time
+    struct Rect rects[CHECK_RECTS];
+    for(int r = 0; r < CHECK_RECTS; r ++) {
+        rects[r].pos.x = randomCoord(400);
+        rects[r].pos.y = randomCoord(400);
+        rects[r].length = 5 + randomCoord(60);
+        rects[r].height = 5 + randomCoord(60);
+    }
+    for(int k = 0; k < CHECK_PAIRS; k ++) {
+        a[k] = nextRandom(&seed) % CHECK_BODIES;
+    }
+    // one circle on the middle of a rect and one on its left edge
+    a[0] = 2;
+    a[1] = 3;
+    bodies.pos_x[2] = rects[0].pos.x + rects[0].length / 2;
+    bodies.pos_y[2] = rects[0].pos.y + rects[0].height / 2;
+    bodies.pos_x[3] = rects[0].pos.x;
+    bodies.pos_y[3] = rects[0].pos.y + 1;
+    failed |= !checkRectKernel("circle vs rect", &bodies, rects, CHECK_RECTS, a, scalar, sse);
+
+    // the level boxes, wide rects with lots of circles each
+    struct Rect level[NUM_LEVEL_RECTS];
+    for(int r = 0; r < NUM_LEVEL_RECTS; r ++) {
+        level[r].pos.x = level_rects[r][0];
+        level[r].pos.y = level_rects[r][1];
+        level[r].length = level_rects[r][2];
+        level[r].height = level_rects[r][3];
+    }
+    for(int i = 0; i < CHECK_BODIES; i ++) {
+        bodies.pos_x[i] = randomCoord(SCREEN_WIDTH);
+        bodies.pos_y[i] = randomCoord(SCREEN_HEIGHT);
+    }
+    failed |= !checkRectKernel("circle vs level rects", &bodies, level, NUM_LEVEL_RECTS, a, scalar, sse);
+
+    free(a);
+    free(b);
+    free(scalar);
+    free(sse);
+    destroyBodies(&bodies);
+    return failed;
+}
+
+// splits the pairs in a evenly over the rects, checks the SSE kernel against the scalar one
+// and prints how long each takes, returns 1 if they match
+int checkRectKernel(const char *name, struct Bodies *bodies, struct Rect *rects, int num_rects, int *a, struct Manifold *scalar, struct Manifold *sse) {
+    int per_rect = CHECK_PAIRS / num_rects;
+    int num_scalar = 0;
+    int num_sse = 0;
+    double scalar_time = 0;
+    double sse_time = 0;
+
+    for(int repeat = 0; repeat < CHECK_REPEATS; repeat ++) {
+        double start = wallTime();
+        num_scalar = 0;
+        for(int r = 0; r < num_rects; r ++) {
+            num_scalar += narrowCircRectScalar(bodies, a + r * per_rect, per_rect, rects, r, scalar + num_scalar);
+        }
+        double middle = wallTime();
+        num_sse = 0;
+        for(int r = 0; r < num_rects; r ++) {
+            num_sse += narrowCircRect(bodies, a + r * per_rect, per_rect, rects, r, sse + num_sse);
+        }
+        sse_time += wallTime() - middle;
+        scalar_time += middle - start;
+    }
+
+    if(!sameContacts(name, scalar, num_scalar, sse, num_sse)) {
+        return 0;
+    }
+    printf("%s: %d pairs, %d contacts, match, scalar %.3f ms, sse %.3f ms\n", name, per_rect * num_rects, num_scalar,
+        scalar_time * 1000 / CHECK_REPEATS, sse_time * 1000 / CHECK_REPEATS);
+    return 1;
+}
+
+// monotonic wall clock in seconds
+double wallTime() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, count;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// most memory the process has held so far, in kilobytes
+long peakMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return pmc.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+void usage() {
+    printf("usage: bench [-s spawn|sweep|pile|crowd|pegs|all] [-n steps] [-c circles] [-r rate]\n");
+    printf("             [-b broadphase] [-x static] [-m step mode] [-o solver]\n");
+    printf("             [-l schedule] [-t threads] [-w pair work] [-S]\n");
+    printf("       bench -k\n");
+}
@@ -1,6 +1,9 @@
 
 #include <stdio.h>
+#include <inttypes.h>
 #include <math.h>
+#include <pthread.h>
+#include <sched.h>
 
 #include <glad/glad.h>              //defines opengl functions, etc
 #include <GLFW/glfw3.h>             //used for window and input
@@ -13,6 +16,7 @@
 #include "sprite.h"
 #include "texman.h"
 #include "phys.h"
+#include "draw.h"
 #include "list.h"
 #include "const.h"
 
@@ -26,12 +30,15 @@ void mouse_callback(GLFWwindow* window, double x_pos, double y_pos);
 void scroll_callback(GLFWwindow* window, double x_offset, double y_offset);
 void glfw_error_callback(int code, const char *err_str);
 GLFWwindow *initializeWindow();
-void updateDefaultUniforms(struct Shader *shader, struct Camera *cam);
 void updateGameState(struct List *objects, float runtime);
+void runFrame(GLFWwindow *window, struct List *objects, float inputs_time, float state_time, float physics_time, float render_time);
+void startSimulation(struct List *objects);
+void spawnTick(struct List *objects, uint64_t tick, void *arg);
+void stopSimulation();
 
 
 float delta_time = 0.0f;
-float last_frame = 0.0f;
+uint64_t last_frame = 0;            // ticks
 
 float last_mouse_x = 400;
 float last_mouse_y = 300;
@@ -42,22 +49,46 @@ uint8_t t_pressed = 0;
 
 struct Camera cam;
 
-struct Circle *mouse;
+struct Node *mouse;
+float mouse_dx = 0;             // mouse movement not yet applied to the world
+float mouse_dy = 0;
+pthread_mutex_t mouse_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// shared by the main loop and physics
+struct Jobs jobs;
 
 int fps_limit = 60;
 
 float spawn_rate = 1;          // how many circles to spawn per second
 float spawn_debt = 0.0f;        // how many circles should have been spawned
-float last_spawn_check = 0.0f;  // last time spawn_debt resolved
+uint64_t last_spawn_check = 0;  // last time spawn_debt resolved, in ticks
+
+// STEP_DETERMINISTIC spawns by step from a fixed seed instead, see spawnTick
+#define SPAWN_SEED 0x5eed1234u
+uint32_t spawn_seed = SPAWN_SEED;
+fixed step_spawn_debt = 0;
+struct Budget spawn_budget;
 
 int inputs_priority = 2;
 int state_priority = 2;
 int physics_priority = 20;
 int render_priority = 2;
 
-#define NUM_SCHEDULERS 2
+#define NUM_SCHEDULERS 3
 int scheduler = 0;
 
+// scheduler 2 steps the world on its own thread and only hands
+// snapshots of it to this one, see simulationMain
+#define SIMULATION_PERIOD (1.0f / 120.0f)   // shortest time between steps
+pthread_t simulation_thread;
+int simulation_running = 0;
+int simulation_quit = 0;
+struct SnapshotBuffer snapshots;
+
+// held while the world is being changed, by the simulation thread during
+// each step and by this thread while it handles input
+pthread_mutex_t world_lock = PTHREAD_MUTEX_INITIALIZER;
+
 int main() {
     printf("running!\n");
 
@@ -85,61 +116,82 @@ int main() {
     // TODO: not sure where to put this...
     // used to be in model.init, but only needs to be called once!
     glUseProgram(shader.id);
-    setInt(&shader, "image", 0);
+    setUniformInt(getUniformInt(&shader, "image"), 0);
+
+    // view and projection live in a buffer every shader shares
+    initCameraBuffer(&cam);
 
     // initialize the texture manager
     struct TexMan texman;
     initTexMan(&texman);
 
     //keep track of FPS
+    initTimer();
     uint64_t total_frames = 0;
-    float start_time = glfwGetTime();
+    uint64_t start_time = getTicks();
 
 
 
+    // this thread is worker 0 and the only one making gl calls
+    initJobs(&jobs, getCoreCount());
+
     // ************* CIRCLE STUFF ************
     initPhysRenderer(&texman, &shader);
+    setPhysJobs(&jobs);
+    setBroadphase(BROADPHASE_GRID);
+    setStepMode(STEP_FIXED);
+    setSolver(SOLVER_SEQUENTIAL);
+    setTickCallback(spawnTick, 0);
+    initSnapshotBuffer(&snapshots);
+    initBudget(&spawn_budget);
 
     struct List objects;
     initList(&objects);
 
     // add the mouse
-    mouse = (struct Circle *)(addCircle(&objects, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, 0, 0, 20, 0))->data;
-    mouse->explosive = 1;
+    mouse = addCircle(&objects, SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, 0, 0, 20, 0);
+    setCircleExplosive(mouse, 1);
+    setFocusCircle(mouse);
     // still objects
-    addRect(&objects, 20, 100, 20, SCREEN_HEIGHT - 100);   // left box
-    addRect(&objects, SCREEN_WIDTH - 40, 100, 20, SCREEN_HEIGHT - 100);   // right box
-    addRect(&objects, 150, SCREEN_HEIGHT - 100, SCREEN_WIDTH - 300, 100);   // center box
-    addCircle(&objects, SCREEN_WIDTH / 2, SCREEN_HEIGHT - 125, 0, 0, 100, 0);   // middle circle
-    addCircle(&objects, SCREEN_WIDTH / 8, SCREEN_HEIGHT / 4, 0, 0, 75, 0);      
-    addCircle(&objects, 7 * SCREEN_WIDTH / 8, SCREEN_HEIGHT / 4, 0, 0, 75, 0);
-    addCircle(&objects, SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 0, 0, 75, 0);      
-    addCircle(&objects, 3 * SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 0, 0, 75, 0);
+    addRect(20, 100, 20, SCREEN_HEIGHT - 100);   // left box
+    addRect(SCREEN_WIDTH - 40, 100, 20, SCREEN_HEIGHT - 100);   // right box
+    addRect(150, SCREEN_HEIGHT - 100, SCREEN_WIDTH - 300, 100);   // center box
+    addStaticCircle(SCREEN_WIDTH / 2, SCREEN_HEIGHT - 125, 100);   // middle circle
+    addStaticCircle(SCREEN_WIDTH / 8, SCREEN_HEIGHT / 4, 75);
+    addStaticCircle(7 * SCREEN_WIDTH / 8, SCREEN_HEIGHT / 4, 75);
+    addStaticCircle(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 75);
+    addStaticCircle(3 * SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2, 75);
 
     //Main loop
     while(!glfwWindowShouldClose(window)) {
         //wait for max FPS limit
         float min_frame_time = (float)(1 / (float)fps_limit);
-        while(glfwGetTime() - last_frame < min_frame_time);
+        uint64_t min_frame_ticks = secondsToTicks(min_frame_time);
+        while(getTicks() - last_frame < min_frame_ticks);
+
+        // start or stop the simulation thread when the scheduler changed
+        if(scheduler == 2 && !simulation_running) {
+            startSimulation(&objects);
+        }
+        else if(scheduler != 2 && simulation_running) {
+            stopSimulation();
+        }
 
         //update time since last frame
-        float current_frame = glfwGetTime();
-        delta_time = current_frame - last_frame;
+        uint64_t current_frame = updateFrameTicks();
+        delta_time = ticksToSeconds(current_frame - last_frame);
         last_frame = current_frame;
         total_frames ++;
 
         // rendering commands
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        updateDefaultUniforms(&shader, &cam);
+        updateCamera(&cam);
         
         // MAIN LOOP
         // default scheduler, give everything all the time
         if(scheduler == 0) {
-            processInput(window, &cam, delta_time, 100);
-            updateGameState(&objects, 100);
-            updatePhysics(&objects, 100);
-            drawObjects(&objects, 100);
+            runFrame(window, &objects, 100, 100, 100, 100);
         }
         // priority based scheduler
         else if(scheduler == 1) {
@@ -150,10 +202,12 @@ int main() {
             float physics_time = (float)physics_priority * min_frame_time / (float)total_priority;
             float render_time = (float)render_priority * min_frame_time / (float)total_priority;
 
-            processInput(window, &cam, delta_time, inputs_time);
-            updateGameState(&objects, state_time);
-            updatePhysics(&objects, physics_time);
-            drawObjects(&objects, render_time);
+            runFrame(window, &objects, inputs_time, state_time, physics_time, render_time);
+        }
+        // threaded scheduler, a slow step never holds up a frame
+        else if(scheduler == 2) {
+            processInput(window, &cam, delta_time, 100);
+            drawSnapshot(latestSnapshot(&snapshots), 100);
         }
 
         // more rendering commands
@@ -161,23 +215,104 @@ int main() {
         glfwPollEvents();
     }
 
+    if(simulation_running) {
+        stopSimulation();
+    }
+    destroySnapshotBuffer(&snapshots);
+    destroyJobs(&jobs);
     destroyList(&objects);
+    destroyPhysRenderer();
+    destroyCamera(&cam);
     destroyTexMan(&texman);
     destroyShader(&shader);
 
-    printf("End of program\n\tframes: %I64d\n\tTime: %f\n\tAverage FPS: %f\n", total_frames, glfwGetTime() - start_time, total_frames / (glfwGetTime() - start_time));
+    double run_time = ticksToSeconds(getTicks() - start_time);
+    printf("End of program\n\tframes: %I64d\n\tTime: %f\n\tAverage FPS: %f\n", total_frames, run_time, total_frames / run_time);
 
     glfwTerminate();
     return 0;
 }
 
+// the part of a frame that can run off the main thread
+struct FrameTasks {
+    struct List *objects;
+    float state_time;
+    float physics_time;
+};
+
+void stateJob(void *arg) {
+    struct FrameTasks *f = arg;
+    updateGameState(f->objects, f->state_time);
+}
+
+void physicsJob(void *arg) {
+    struct FrameTasks *f = arg;
+    updatePhysics(f->objects, f->physics_time);
+}
+
+// one frame as a job graph: input -> state -> physics -> draw
+// input and drawing talk to glfw and gl, so they run on this thread,
+// state and physics are jobs and this thread helps with them while it waits
+// spawning adds bodies, so physics waits on the state job
+void runFrame(GLFWwindow *window, struct List *objects, float inputs_time, float state_time, float physics_time, float render_time) {
+    processInput(window, &cam, delta_time, inputs_time);
+
+    struct FrameTasks f = {objects, state_time, physics_time};
+    struct Job state, physics;
+    initJob(&state, stateJob, &f);
+    initJob(&physics, physicsJob, &f);
+    addJobDependency(&physics, &state);
+    submitJob(&jobs, &physics);
+    submitJob(&jobs, &state);
+    waitJob(&jobs, &physics);
+
+    drawObjects(objects, render_time);
+}
+
+// steps the world and publishes a snapshot of it, until stopSimulation
+void *simulationMain(void *arg) {
+    struct List *objects = arg;
+
+    while(!__sync_fetch_and_add(&simulation_quit, 0)) {
+        uint64_t start = updateFrameTicks();
+
+        pthread_mutex_lock(&world_lock);
+        updateGameState(objects, 100);
+        updatePhysics(objects, 100);
+        writeSnapshot(beginSnapshot(&snapshots));
+        pthread_mutex_unlock(&world_lock);
+        publishSnapshot(&snapshots);
+
+        // give input a chance at the lock, and don't step faster than needed
+        while(getTicks() - start < secondsToTicks(SIMULATION_PERIOD)) {
+            sched_yield();
+        }
+    }
+
+    return 0;
+}
+
+void startSimulation(struct List *objects) {
+    simulation_quit = 0;
+    if(pthread_create(&simulation_thread, 0, simulationMain, objects) != 0) {
+        printf("error starting simulation thread\n");
+        scheduler = 0;
+        return;
+    }
+    simulation_running = 1;
+}
+
+void stopSimulation() {
+    __sync_fetch_and_add(&simulation_quit, 1);
+    pthread_join(simulation_thread, 0);
+    simulation_running = 0;
+}
+
 //should definitely use key callback for this
 //  keycallback insures that will we handle the input
 //  even if they release the key before we process the input
 //  in the loop
 void processInput(GLFWwindow *window, struct Camera *cam, float dt, float runtime) {
-    float start_time = glfwGetTime();
-
     int escape = glfwGetKey(window, GLFW_KEY_ESCAPE);
     int w = glfwGetKey(window, GLFW_KEY_W);
     int a = glfwGetKey(window, GLFW_KEY_A);
@@ -187,6 +322,12 @@ void processInput(GLFWwindow *window, struct Camera *cam, float dt, float runtim
     
     int i = glfwGetKey(window, GLFW_KEY_I);
     int f = glfwGetKey(window, GLFW_KEY_F);
+    int b = glfwGetKey(window, GLFW_KEY_B);
+    int g = glfwGetKey(window, GLFW_KEY_G);
+    int p = glfwGetKey(window, GLFW_KEY_P);
+    int v = glfwGetKey(window, GLFW_KEY_V);
+    int h = glfwGetKey(window, GLFW_KEY_H);
+    int l = glfwGetKey(window, GLFW_KEY_L);
     int up = glfwGetKey(window, GLFW_KEY_UP);
     int dn = glfwGetKey(window, GLFW_KEY_DOWN);
     int left = glfwGetKey(window, GLFW_KEY_LEFT);
@@ -224,19 +365,51 @@ void processInput(GLFWwindow *window, struct Camera *cam, float dt, float runtim
         t_pressed = 0;
     }
 
+    // the rest changes the world, which the simulation thread may be stepping
+    // rather than wait for it, skip this frame, held keys are seen again next frame
+    if(pthread_mutex_trylock(&world_lock) != 0) {
+        return;
+    }
+
+    // level of detail also follows the middle of the view
+    setFocusPoint(cam->position[0] + SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 - cam->position[1]);
+
     // used for fake "debouncing"...
-    static double press_time = 0;
-    if(i == GLFW_PRESS && glfwGetTime() - press_time > 1) {
+    static uint64_t press_time = 0;
+    if(i == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
         printf("i pressed\n");
         printf("spawn_rate: %.2f circles per second\n", spawn_rate);
         printf("using scheduler: %d\n", scheduler);
+        struct PhysStats stats;
+        getPhysStats(&stats);
+        printf("broadphase: %d\n", getBroadphase());
+        printf("step mode: %d schedule: %d\n", getStepMode(), getSchedule());
+        printf("solver: %d iterations: %d\n", getSolver(), getSolverIterations());
+        printf("threads: %d of %d cores\n", getPhysThreads(), getCoreCount());
+        printf("pair tests: %lu contacts: %lu bodies updated: %lu sleeping: %lu\n", stats.pair_tests, stats.contacts, stats.bodies_updated, stats.sleeping);
+        if(stats.steps > 0) {
+            printf("physics: %.3f ms per update over %lu updates\n", stats.step_time * 1000 / stats.steps, stats.steps);
+            printf("longest wait for a variable step: %.3f s\n", stats.max_staleness);
+            printf("worst overrun: %.3f ms (tolerance %.0f%%)\n", stats.max_overrun * 1000, getBudgetTolerance() * 100);
+        }
+        if(getStepMode() == STEP_DETERMINISTIC) {
+            printf("deterministic step %" PRIu64 " state hash %08x\n", getPhysTick(), hashPhysState());
+        }
+        struct RenderStats draw_stats;
+        getDrawStats(&draw_stats);
+        if(draw_stats.submits > 0) {
+            float n = draw_stats.submits;
+            printf("per frame: commands: %.1f draws: %.1f program changes: %.1f texture changes: %.1f vao changes: %.1f\n",
+                draw_stats.commands / n, draw_stats.draws / n, draw_stats.program_changes / n,
+                draw_stats.texture_changes / n, draw_stats.VAO_changes / n);
+        }
         fflush(stdout);
-        press_time = glfwGetTime();
+        press_time = getFrameTicks();
     }
 
-    if(f == GLFW_PRESS && glfwGetTime() - press_time > 1) {
+    if(f == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
         printf("Switching Frame Limit\n");
-        press_time = glfwGetTime();
+        press_time = getFrameTicks();
         if(fps_limit == 144) {
             printf("switching to 60\n");
             fps_limit = 60;
@@ -252,6 +425,61 @@ void processInput(GLFWwindow *window, struct Camera *cam, float dt, float runtim
         fflush(stdout);
     }
 
+    if(b == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
+        setBroadphase((getBroadphase() + 1) % NUM_BROADPHASES);
+        printf("switching to broadphase %d\n", getBroadphase());
+        fflush(stdout);
+    }
+
+    if(g == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
+        setStaticCollision((getStaticCollision() + 1) % NUM_STATIC_COLLISIONS);
+        printf("switching to static collision %d\n", getStaticCollision());
+        fflush(stdout);
+    }
+
+    if(p == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
+        setStepMode((getStepMode() + 1) % NUM_STEP_MODES);
+        printf("switching to step mode %d\n", getStepMode());
+        if(getStepMode() == STEP_DETERMINISTIC) {
+            spawn_seed = SPAWN_SEED;
+            step_spawn_debt = 0;
+        }
+        fflush(stdout);
+    }
+
+    if(v == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
+        setSolver((getSolver() + 1) % NUM_SOLVERS);
+        printf("switching to solver %d\n", getSolver());
+        fflush(stdout);
+    }
+
+    // doubles the physics threads up to the core count, then back to 1
+    // press i before and after to compare update times
+    if(h == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
+        int threads = getPhysThreads() * 2;
+        if(getPhysThreads() >= getCoreCount()) {
+            threads = 1;
+        }
+        else if(threads > getCoreCount()) {
+            threads = getCoreCount();
+        }
+        setPhysThreads(threads);
+        printf("switching to %d physics threads\n", getPhysThreads());
+        fflush(stdout);
+    }
+
+    if(l == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
+        setSchedule((getSchedule() + 1) % NUM_SCHEDULES);
+        printf("switching to schedule %d\n", getSchedule());
+        fflush(stdout);
+    }
+
     if(up == GLFW_PRESS) {
         spawn_rate += 0.1;
     }
@@ -263,18 +491,19 @@ void processInput(GLFWwindow *window, struct Camera *cam, float dt, float runtim
         }
     }
 
-    if(left == GLFW_PRESS && glfwGetTime() - press_time > 1) {
-        press_time = glfwGetTime();
+    if(left == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
         scheduler --;
         if(scheduler < 0) {
             scheduler = NUM_SCHEDULERS - 1;
         }
     }
-    if(right == GLFW_PRESS && glfwGetTime() - press_time > 1) {
-        press_time = glfwGetTime();
+    if(right == GLFW_PRESS && getFrameTicks() - press_time > TICKS_PER_SECOND) {
+        press_time = getFrameTicks();
         scheduler = (scheduler + 1) % NUM_SCHEDULERS;
     }
 
+    pthread_mutex_unlock(&world_lock);
 }
 
 void mouse_callback(GLFWwindow* window, double x_pos, double y_pos) {
@@ -285,13 +514,18 @@ void mouse_callback(GLFWwindow* window, double x_pos, double y_pos) {
         first_mouse = 0;
     }
 
-    float dx = x_pos - last_mouse_x;
-    float dy = y_pos - last_mouse_y;
+    // a pixel covers less of the world the further in the camera is zoomed
+    float scale = cam.zoom / CAMERA_MAX_ZOOM;
+    float dx = (x_pos - last_mouse_x) * scale;
+    float dy = (y_pos - last_mouse_y) * scale;
     last_mouse_x = x_pos;
     last_mouse_y = y_pos;
 
-    mouse->pos.x += dx;
-    mouse->pos.y += dy;
+    // the world may be mid step on another thread, updateGameState moves the circle
+    pthread_mutex_lock(&mouse_lock);
+    mouse_dx += dx;
+    mouse_dy += dy;
+    pthread_mutex_unlock(&mouse_lock);
 }
 
 void scroll_callback(GLFWwindow* window, double x_offset, double y_offset) {
@@ -335,32 +569,53 @@ GLFWwindow *initializeWindow() {
     return window;
 }
 
-// name WIP
-// all models using default shader have these same uniforms. So just update them
-// all here!
-void updateDefaultUniforms(struct Shader *shader, struct Camera *cam) {
-    // construct matrices for camera
-    mat4 view, projection;
-    glm_translate_make(view, (vec3){-1 * cam->position[0], cam->position[1], 0.0f});
-    // This is where zoom would be incorporated (maybe??)
-    glm_ortho(0.0, SCREEN_WIDTH, SCREEN_HEIGHT, 0.0, -1.0, 1.0, projection);
-    setMat4(shader, "view", view);
-    setMat4(shader, "projection", projection);
-}
-
 void updateGameState(struct List *objects, float runtime) {
-    float start_time = glfwGetTime();
-
-    spawn_debt += (glfwGetTime() - last_spawn_check) * spawn_rate;
-    last_spawn_check = glfwGetTime();
+    uint64_t start_time = getTicks();
+    startBudget(&spawn_budget, start_time, runtime);
+
+    pthread_mutex_lock(&mouse_lock);
+    translateCircle(mouse, mouse_dx, mouse_dy);
+    mouse_dx = 0;
+    mouse_dy = 0;
+    pthread_mutex_unlock(&mouse_lock);
+
+    spawn_debt += ticksToSeconds(start_time - last_spawn_check) * spawn_rate;
+    last_spawn_check = start_time;
+
+    // spawnTick does it by step
+    if(getStepMode() == STEP_DETERMINISTIC) {
+        spawn_debt = 0;
+        return;
+    }
 
     // spawn new circles
-    while(spawn_debt >= 1.0f && glfwGetTime() - start_time < runtime) {
+    int batch = 0;
+    while(spawn_debt >= 1.0f && (batch = nextBatch(&spawn_budget, batch)) > 0) {
+        if(batch > spawn_debt) {
+            batch = spawn_debt;
+        }
+        for(int k = 0; k < batch; k ++) {
+            int x_var = 3 * SCREEN_WIDTH / 4;
+            int y_var = 100;
+            x_var = rand() % x_var - x_var / 2;
+            y_var = rand() % y_var - y_var / 2;
+            addCircle(objects, SCREEN_WIDTH / 2 + x_var, 100 + y_var, 0, 0, 7.5, 1);
+        }
+        spawn_debt -= batch;
+    }
+}
+
+// spawns like updateGameState, but counting steps instead of time and
+// with its own random numbers, so every deterministic run spawns the same
+void spawnTick(struct List *objects, uint64_t tick, void *arg) {
+    step_spawn_debt += fxMul(toFixed(spawn_rate), toFixed(FIXED_DT));
+
+    while(step_spawn_debt >= FX_ONE) {
         int x_var = 3 * SCREEN_WIDTH / 4;
         int y_var = 100;
-        x_var = rand() % x_var - x_var / 2;
-        y_var = rand() % y_var - y_var / 2;
+        x_var = (int)(nextRandom(&spawn_seed) % x_var) - x_var / 2;
+        y_var = (int)(nextRandom(&spawn_seed) % y_var) - y_var / 2;
         addCircle(objects, SCREEN_WIDTH / 2 + x_var, 100 + y_var, 0, 0, 7.5, 1);
-        spawn_debt -= 1.0f;
+        step_spawn_debt -= FX_ONE;
     }
 }
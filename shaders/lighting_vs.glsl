@@ -10,8 +10,11 @@ out vec3 normal_vec;
 out vec2 tex_coords;
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// shared by every shader, see camera.h
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
 
 void main() {
     frag_pos = vec3(model * vec4(pos, 1.0));
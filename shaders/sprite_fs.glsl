@@ -3,11 +3,11 @@
 
 // Uniforms
 uniform sampler2D image;
-uniform vec3 sprite_color;
 
 // ***** inputs / outputs *****
 out vec4 color;
 in vec2 tex_coords;
+in vec3 sprite_color;
 
 void main() {
     // for more on alpha stuff, see: opengl blending tutorial on learnopengl.com
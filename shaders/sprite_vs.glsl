@@ -4,14 +4,30 @@
 layout (location = 0) in vec2 pos;
 layout (location = 1) in vec2 tex_coords_in;
 
+// per instance
+layout (location = 2) in vec4 rect;         // top left corner, then size
+layout (location = 3) in float rotation;
+layout (location = 4) in vec3 color;
+layout (location = 5) in vec4 uv_rect;      // where the texture is in its atlas page
+
 out vec2 tex_coords;
+out vec3 sprite_color;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// shared by every shader, see camera.h
+layout (std140) uniform Camera {
+    mat4 view;
+    mat4 projection;
+};
 
 void main() {
-    tex_coords = tex_coords_in;
-    gl_Position = projection * view * model  * vec4(pos, 0.0, 1.0);
+    // scale the unit quad, rotate it about its center, then move it into place
+    vec2 p = (pos - 0.5) * rect.zw;
+    float c = cos(rotation);
+    float s = sin(rotation);
+    p = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + rect.xy + 0.5 * rect.zw;
+
+    tex_coords = uv_rect.xy + tex_coords_in * uv_rect.zw;
+    sprite_color = color;
+    gl_Position = projection * view * vec4(p, 0.0, 1.0);
 }
 
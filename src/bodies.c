@@ -0,0 +1,193 @@
+#include "bodies.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ********** private functions **********
+
+static void *growArray(void *arr, int new_capacity, int elem_size) {
+    void *temp = realloc(arr, new_capacity * elem_size);
+    if(temp == 0) {
+        printf("error allocating memory for bodies\n");
+        exit(1);
+    }
+    return temp;
+}
+
+static void growBodies(struct Bodies *b) {
+    int c = b->capacity == 0 ? 256 : b->capacity * 2;
+
+    b->pos_x = growArray(b->pos_x, c, sizeof(float));
+    b->pos_y = growArray(b->pos_y, c, sizeof(float));
+    b->vel_x = growArray(b->vel_x, c, sizeof(float));
+    b->vel_y = growArray(b->vel_y, c, sizeof(float));
+    b->radius = growArray(b->radius, c, sizeof(float));
+    b->inv_mass = growArray(b->inv_mass, c, sizeof(float));
+    b->prev_x = growArray(b->prev_x, c, sizeof(float));
+    b->prev_y = growArray(b->prev_y, c, sizeof(float));
+
+    b->mass = growArray(b->mass, c, sizeof(float));
+    b->id = growArray(b->id, c, sizeof(int));
+    b->restitution = growArray(b->restitution, c, sizeof(float));
+    b->explosive = growArray(b->explosive, c, sizeof(int));
+    b->last_update_time = growArray(b->last_update_time, c, sizeof(uint64_t));
+    b->grid_x = growArray(b->grid_x, c, sizeof(float));
+    b->grid_y = growArray(b->grid_y, c, sizeof(float));
+    b->skipped = growArray(b->skipped, c, sizeof(int));
+    b->proxy = growArray(b->proxy, c, sizeof(int));
+    b->sleeping = growArray(b->sleeping, c, sizeof(int));
+    b->sleep_time = growArray(b->sleep_time, c, sizeof(float));
+    b->sleep_x = growArray(b->sleep_x, c, sizeof(float));
+    b->sleep_y = growArray(b->sleep_y, c, sizeof(float));
+    b->sleep_island = growArray(b->sleep_island, c, sizeof(int));
+    b->node = growArray(b->node, c, sizeof(struct Node *));
+    b->fx_pos_x = growArray(b->fx_pos_x, c, sizeof(fixed));
+    b->fx_pos_y = growArray(b->fx_pos_y, c, sizeof(fixed));
+    b->fx_vel_x = growArray(b->fx_vel_x, c, sizeof(fixed));
+    b->fx_vel_y = growArray(b->fx_vel_y, c, sizeof(fixed));
+    b->fx_sleep_x = growArray(b->fx_sleep_x, c, sizeof(fixed));
+    b->fx_sleep_y = growArray(b->fx_sleep_y, c, sizeof(fixed));
+    b->still_steps = growArray(b->still_steps, c, sizeof(int));
+
+    b->color_r = growArray(b->color_r, c, sizeof(float));
+    b->color_g = growArray(b->color_g, c, sizeof(float));
+    b->color_b = growArray(b->color_b, c, sizeof(float));
+
+    b->capacity = c;
+}
+
+// ********** public functions **********
+
+int initBodies(struct Bodies *b) {
+    memset(b, 0, sizeof(*b));
+    return 0;
+}
+
+int addBody(struct Bodies *b) {
+    if(b->count >= b->capacity) {
+        growBodies(b);
+    }
+
+    int i = b->count ++;
+    b->pos_x[i] = 0;
+    b->pos_y[i] = 0;
+    b->vel_x[i] = 0;
+    b->vel_y[i] = 0;
+    b->radius[i] = 0;
+    b->inv_mass[i] = 0;
+    b->prev_x[i] = 0;
+    b->prev_y[i] = 0;
+    b->mass[i] = 0;
+    b->id[i] = b->next_id ++;
+    b->restitution[i] = 0;
+    b->explosive[i] = 0;
+    b->last_update_time[i] = 0;
+    b->grid_x[i] = 0;
+    b->grid_y[i] = 0;
+    b->skipped[i] = 0;
+    b->proxy[i] = -1;
+    b->sleeping[i] = 0;
+    b->sleep_time[i] = 0;
+    b->sleep_x[i] = 0;
+    b->sleep_y[i] = 0;
+    b->sleep_island[i] = -1;
+    b->node[i] = 0;
+    b->fx_pos_x[i] = 0;
+    b->fx_pos_y[i] = 0;
+    b->fx_vel_x[i] = 0;
+    b->fx_vel_y[i] = 0;
+    b->fx_sleep_x[i] = 0;
+    b->fx_sleep_y[i] = 0;
+    b->still_steps[i] = 0;
+    b->color_r[i] = 1.0f;
+    b->color_g[i] = 1.0f;
+    b->color_b[i] = 1.0f;
+
+    return i;
+}
+
+void removeBody(struct Bodies *b, int i) {
+    int last = -- b->count;
+    if(i == last) {
+        return;
+    }
+
+    b->pos_x[i] = b->pos_x[last];
+    b->pos_y[i] = b->pos_y[last];
+    b->vel_x[i] = b->vel_x[last];
+    b->vel_y[i] = b->vel_y[last];
+    b->radius[i] = b->radius[last];
+    b->inv_mass[i] = b->inv_mass[last];
+    b->prev_x[i] = b->prev_x[last];
+    b->prev_y[i] = b->prev_y[last];
+    b->mass[i] = b->mass[last];
+    b->id[i] = b->id[last];
+    b->restitution[i] = b->restitution[last];
+    b->explosive[i] = b->explosive[last];
+    b->last_update_time[i] = b->last_update_time[last];
+    b->grid_x[i] = b->grid_x[last];
+    b->grid_y[i] = b->grid_y[last];
+    b->skipped[i] = b->skipped[last];
+    b->proxy[i] = b->proxy[last];
+    b->sleeping[i] = b->sleeping[last];
+    b->sleep_time[i] = b->sleep_time[last];
+    b->sleep_x[i] = b->sleep_x[last];
+    b->sleep_y[i] = b->sleep_y[last];
+    b->sleep_island[i] = b->sleep_island[last];
+    b->node[i] = b->node[last];
+    b->fx_pos_x[i] = b->fx_pos_x[last];
+    b->fx_pos_y[i] = b->fx_pos_y[last];
+    b->fx_vel_x[i] = b->fx_vel_x[last];
+    b->fx_vel_y[i] = b->fx_vel_y[last];
+    b->fx_sleep_x[i] = b->fx_sleep_x[last];
+    b->fx_sleep_y[i] = b->fx_sleep_y[last];
+    b->still_steps[i] = b->still_steps[last];
+    b->color_r[i] = b->color_r[last];
+    b->color_g[i] = b->color_g[last];
+    b->color_b[i] = b->color_b[last];
+
+    if(b->node[i] != 0) {
+        *(int *)b->node[i]->data = i;
+    }
+}
+
+int bodyIndex(struct Node *node) {
+    return *(int *)node->data;
+}
+
+void destroyBodies(struct Bodies *b) {
+    free(b->pos_x);
+    free(b->pos_y);
+    free(b->vel_x);
+    free(b->vel_y);
+    free(b->radius);
+    free(b->inv_mass);
+    free(b->prev_x);
+    free(b->prev_y);
+    free(b->mass);
+    free(b->id);
+    free(b->restitution);
+    free(b->explosive);
+    free(b->last_update_time);
+    free(b->grid_x);
+    free(b->grid_y);
+    free(b->skipped);
+    free(b->proxy);
+    free(b->sleeping);
+    free(b->sleep_time);
+    free(b->sleep_x);
+    free(b->sleep_y);
+    free(b->sleep_island);
+    free(b->node);
+    free(b->fx_pos_x);
+    free(b->fx_pos_y);
+    free(b->fx_vel_x);
+    free(b->fx_vel_y);
+    free(b->fx_sleep_x);
+    free(b->fx_sleep_y);
+    free(b->still_steps);
+    free(b->color_r);
+    free(b->color_g);
+    free(b->color_b);
+    initBodies(b);
+}
@@ -0,0 +1,78 @@
+#ifndef BODIES_H
+#define BODIES_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "list.h"
+#include "fixed.h"
+
+// Structure of arrays storage for moving circles.
+// Body i is element i of every array. Arrays stay dense: removing a body
+// moves the last body into its slot, so indices are not stable. Code that
+// needs to keep hold of a body keeps its list node, whose data is the
+// body's current index.
+struct Bodies {
+    int count;
+    int capacity;
+    int next_id;
+
+    // hot, touched by every step
+    float *pos_x;
+    float *pos_y;
+    float *vel_x;
+    float *vel_y;
+    float *radius;
+    float *inv_mass;
+
+    // position at the start of the last fixed step, for interpolation
+    float *prev_x;
+    float *prev_y;
+
+    // per body state used by response and scheduling
+    int *id;                    // unique for the body's lifetime, unlike its index
+    float *mass;
+    float *restitution;
+    int *explosive;
+    uint64_t *last_update_time; // ticks
+    float *grid_x;              // where the grid was last built with it
+    float *grid_y;
+    int *skipped;               // passes since the body was last visited
+    int *proxy;                 // sweep and prune proxy, -1 if none
+    int *sleeping;              // skipped by narrow phase and integration
+    float *sleep_time;          // how long the body has been nearly still
+    float *sleep_x;             // where it was when sleep_time started
+    float *sleep_y;
+    int *sleep_island;          // id of the island it fell asleep with, -1 while awake
+    struct Node **node;         // handle in the objects list
+
+    // STEP_DETERMINISTIC state, the float position and velocity mirror it
+    fixed *fx_pos_x;
+    fixed *fx_pos_y;
+    fixed *fx_vel_x;
+    fixed *fx_vel_y;
+    fixed *fx_sleep_x;          // sleep_x and sleep_y
+    fixed *fx_sleep_y;
+    int *still_steps;           // sleep_time counted in steps
+
+    // cold, only used for drawing
+    float *color_r;
+    float *color_g;
+    float *color_b;
+};
+
+int initBodies(struct Bodies *b);
+
+// appends a zeroed body and returns its index
+int addBody(struct Bodies *b);
+
+// removes body i by moving the last body into its place
+// the moved body's node is updated to its new index
+void removeBody(struct Bodies *b, int i);
+
+// index of the body a list node refers to
+int bodyIndex(struct Node *node);
+
+void destroyBodies(struct Bodies *b);
+
+#endif
@@ -0,0 +1,72 @@
+#include "budget.h"
+#include "timer.h"
+
+static float tolerance = BUDGET_TOLERANCE;
+
+// ********** public functions **********
+
+int initBudget(struct Budget *b) {
+    b->cost = 0;
+    b->end = 0;
+    b->slack = 0;
+    b->last = 0;
+    b->overrun = 0;
+    b->unlimited = 1;
+    return 0;
+}
+
+void startBudget(struct Budget *b, uint64_t start, float runtime) {
+    b->unlimited = runtime < 0;
+    b->end = b->unlimited ? start : start + secondsToTicks(runtime);
+    b->slack = runtime * tolerance;
+    b->last = start;
+    b->overrun = 0;
+}
+
+int nextBatch(struct Budget *b, int done) {
+    if(b->unlimited) {
+        return BUDGET_MAX_BATCH;
+    }
+
+    uint64_t now = getTicks();
+    if(done > 0) {
+        float measured = ticksToSeconds(now - b->last) / done;
+        if(b->cost == 0) {
+            b->cost = measured;
+        }
+        else {
+            b->cost += (measured - b->cost) * BUDGET_GAIN;
+        }
+    }
+    b->last = now;
+
+    if(now >= b->end) {
+        b->overrun = ticksToSeconds(now - b->end);
+        return 0;
+    }
+    float remaining = ticksToSeconds(b->end - now);
+
+    // too cheap for the clock to see yet, grow until it does
+    if(b->cost <= 0) {
+        if(done == 0) {
+            return 1;
+        }
+        return done < BUDGET_MAX_BATCH / 2 ? done * 2 : BUDGET_MAX_BATCH;
+    }
+
+    float n = (remaining / 2 + b->slack) / b->cost;
+    if(n < 1) {
+        return 1;
+    }
+    return n > BUDGET_MAX_BATCH ? BUDGET_MAX_BATCH : (int)n;
+}
+
+void setBudgetTolerance(float t) {
+    if(t >= 0) {
+        tolerance = t;
+    }
+}
+
+float getBudgetTolerance() {
+    return tolerance;
+}
@@ -0,0 +1,44 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include <stdint.h>
+
+// fraction of a call's runtime it may plan to run past it by
+#define BUDGET_TOLERANCE 0.05f
+
+// largest batch nextBatch hands out, also the batch when there is no limit
+#define BUDGET_MAX_BATCH (1 << 20)
+
+// how much of the error one batch corrects the cost estimate by
+#define BUDGET_GAIN 0.25f
+
+// Time budget for a loop over many cheap items.
+// Instead of reading the clock for every item, the loop asks for a batch,
+// runs that many items and asks again. The batch is sized from a running
+// estimate of the cost per item to fill half the time left plus the
+// tolerance, so a call reads the clock a handful of times and, as long as
+// the estimate holds, ends within the tolerance of its runtime.
+// The estimate carries over between calls, so keep one budget per loop.
+struct Budget {
+    float cost;             // seconds per item, 0 until measured
+    uint64_t end;           // ticks when the current call should stop
+    float slack;            // seconds past end a batch may be planned to go
+    uint64_t last;          // ticks when the current batch started
+    float overrun;          // how far past end the current call went
+    int unlimited;
+};
+
+int initBudget(struct Budget *b);
+
+// starts a call that began at start ticks and may take runtime seconds, negative for no limit
+void startBudget(struct Budget *b, uint64_t start, float runtime);
+
+// done is how many items were run since the last call, 0 on the first
+// returns how many to run next, 0 once out of time
+int nextBatch(struct Budget *b, int done);
+
+// shared by every budget
+void setBudgetTolerance(float t);
+float getBudgetTolerance();
+
+#endif
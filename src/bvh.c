@@ -0,0 +1,169 @@
+#include "bvh.h"
+
+#include <stdio.h>
+#include <math.h>
+
+#define BVH_LEAF_SIZE 2
+#define BVH_MAX_DEPTH 64
+
+// ********** private functions **********
+
+// box data used while building
+struct BuildItem {
+    float min[2];
+    float max[2];
+    float center[2];
+    int id;
+};
+
+static int sort_axis = 0;
+
+static int compareCenters(const void *a, const void *b) {
+    float ca = ((struct BuildItem *)a)->center[sort_axis];
+    float cb = ((struct BuildItem *)b)->center[sort_axis];
+    return (ca > cb) - (ca < cb);
+}
+
+// builds the subtree over items[start, start + count), returns its node
+static int buildNode(struct Bvh *b, struct BuildItem *items, int start, int count, int depth) {
+    int index = b->num_nodes ++;
+    struct BvhNode *node = &b->nodes[index];
+
+    node->min[0] = node->min[1] = INFINITY;
+    node->max[0] = node->max[1] = -INFINITY;
+    for(int i = start; i < start + count; i ++) {
+        for(int axis = 0; axis < 2; axis ++) {
+            if(items[i].min[axis] < node->min[axis]) {
+                node->min[axis] = items[i].min[axis];
+            }
+            if(items[i].max[axis] > node->max[axis]) {
+                node->max[axis] = items[i].max[axis];
+            }
+        }
+    }
+
+    if(count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH - 1) {
+        node->first = start;
+        node->count = count;
+        return index;
+    }
+
+    // split at the median of the longest axis
+    sort_axis = (node->max[0] - node->min[0]) < (node->max[1] - node->min[1]);
+    qsort(items + start, count, sizeof(struct BuildItem), compareCenters);
+    int half = count / 2;
+
+    node->count = 0;
+    buildNode(b, items, start, half, depth + 1);
+    node->first = buildNode(b, items, start + half, count - half, depth + 1);
+
+    return index;
+}
+
+static int boxesOverlap(struct BvhNode *n, float min_x, float min_y, float max_x, float max_y) {
+    return n->min[0] <= max_x && min_x <= n->max[0]
+        && n->min[1] <= max_y && min_y <= n->max[1];
+}
+
+// ********** public functions **********
+
+int initBvh(struct Bvh *b) {
+    b->nodes = 0;
+    b->num_nodes = 0;
+    b->items = 0;
+    b->item_bounds = 0;
+    b->num_items = 0;
+
+    return 0;
+}
+
+void buildBvh(struct Bvh *b, const float *bounds, const int *ids, int n) {
+    destroyBvh(b);
+    if(n == 0) {
+        return;
+    }
+
+    struct BuildItem *items = malloc(n * sizeof(struct BuildItem));
+    // a binary tree with n leaves has fewer than 2n nodes
+    b->nodes = malloc(2 * n * sizeof(struct BvhNode));
+    b->items = malloc(n * sizeof(int));
+    b->item_bounds = malloc(n * 4 * sizeof(float));
+    if(items == 0 || b->nodes == 0 || b->items == 0 || b->item_bounds == 0) {
+        printf("error allocating memory for bvh\n");
+        exit(1);
+    }
+
+    for(int i = 0; i < n; i ++) {
+        items[i].min[0] = bounds[i * 4 + 0];
+        items[i].min[1] = bounds[i * 4 + 1];
+        items[i].max[0] = bounds[i * 4 + 2];
+        items[i].max[1] = bounds[i * 4 + 3];
+        items[i].center[0] = (items[i].min[0] + items[i].max[0]) / 2;
+        items[i].center[1] = (items[i].min[1] + items[i].max[1]) / 2;
+        items[i].id = ids[i];
+    }
+
+    buildNode(b, items, 0, n, 0);
+
+    for(int i = 0; i < n; i ++) {
+        b->items[i] = items[i].id;
+        b->item_bounds[i * 4 + 0] = items[i].min[0];
+        b->item_bounds[i * 4 + 1] = items[i].min[1];
+        b->item_bounds[i * 4 + 2] = items[i].max[0];
+        b->item_bounds[i * 4 + 3] = items[i].max[1];
+    }
+    b->num_items = n;
+
+    free(items);
+}
+
+int queryBvh(struct Bvh *b, float min_x, float min_y, float max_x, float max_y, int **out, int *out_capacity) {
+    int stack[BVH_MAX_DEPTH + 1];
+    int top = 0;
+    int n = 0;
+
+    if(b->num_nodes == 0) {
+        return 0;
+    }
+
+    stack[top ++] = 0;
+    while(top > 0) {
+        int index = stack[-- top];
+        struct BvhNode *node = &b->nodes[index];
+
+        if(!boxesOverlap(node, min_x, min_y, max_x, max_y)) {
+            continue;
+        }
+
+        if(node->count > 0) {
+            for(int i = node->first; i < node->first + node->count; i ++) {
+                float *ib = &b->item_bounds[i * 4];
+                if(ib[0] > max_x || min_x > ib[2] || ib[1] > max_y || min_y > ib[3]) {
+                    continue;
+                }
+                if(n >= *out_capacity) {
+                    *out_capacity = *out_capacity == 0 ? 16 : *out_capacity * 2;
+                    *out = realloc(*out, *out_capacity * sizeof(int));
+                    if(*out == 0) {
+                        printf("error allocating memory for bvh query\n");
+                        exit(1);
+                    }
+                }
+                (*out)[n ++] = b->items[i];
+            }
+        }
+        else {
+            stack[top ++] = node->first;
+            stack[top ++] = index + 1;
+        }
+    }
+
+    return n;
+}
+
+void destroyBvh(struct Bvh *b) {
+    free(b->nodes);
+    free(b->items);
+    free(b->item_bounds);
+    initBvh(b);
+}
@@ -0,0 +1,37 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <stdlib.h>
+
+// Bounding volume hierarchy over axis aligned boxes.
+// Built once from a fixed set of items and never refit, meant for
+// geometry that does not move.
+
+struct BvhNode {
+    float min[2];
+    float max[2];
+    int first;      // leaf: first entry in items, inner: right child
+    int count;      // leaf: number of items, inner: 0 (left child is next)
+};
+
+struct Bvh {
+    struct BvhNode *nodes;
+    int num_nodes;
+    int *items;
+    float *item_bounds;     // 4 floats per entry in items
+    int num_items;
+};
+
+int initBvh(struct Bvh *b);
+
+// builds the tree over n boxes
+// bounds holds min_x, min_y, max_x, max_y for each box, ids are given back by queries
+void buildBvh(struct Bvh *b, const float *bounds, const int *ids, int n);
+
+// writes the id of every box overlapping the query box into out
+// out grows with realloc as needed, returns how many were found
+int queryBvh(struct Bvh *b, float min_x, float min_y, float max_x, float max_y, int **out, int *out_capacity);
+
+void destroyBvh(struct Bvh *b);
+
+#endif
@@ -5,6 +5,8 @@
     glm_vec_copy(position, cam->position);
     cam->movement_speed = movement_speed;
     cam->zoom = zoom;
+    cam->UBO = 0;
+    cam->dirty = 1;
 
 }
 
@@ -26,14 +28,50 @@ void translateCamera(struct Camera *cam, enum camera_movement direction, float d
     if(direction == cam_down) {
         cam->position[1] -= velocity;
     }
+
+    __atomic_store_n(&cam->dirty, 1, __ATOMIC_RELEASE);
 }
 
 void zoomCamera(struct Camera *cam, float y_offset) {
-    //can move these constraints to constants
-    if(cam->zoom >= 1.0f && cam->zoom <= 45.0f)
+    if(cam->zoom >= CAMERA_MIN_ZOOM && cam->zoom <= CAMERA_MAX_ZOOM)
         cam->zoom -= y_offset;
-    if(cam->zoom <= 1.0f)
-        cam->zoom = 1.0f;
-    if(cam->zoom >= 45.0f)
-        cam->zoom = 45.0f;
+    if(cam->zoom <= CAMERA_MIN_ZOOM)
+        cam->zoom = CAMERA_MIN_ZOOM;
+    if(cam->zoom >= CAMERA_MAX_ZOOM)
+        cam->zoom = CAMERA_MAX_ZOOM;
+
+    __atomic_store_n(&cam->dirty, 1, __ATOMIC_RELEASE);
+}
+
+void initCameraBuffer(struct Camera *cam) {
+    glGenBuffers(1, &cam->UBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, cam->UBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(struct CameraBlock), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, cam->UBO);
+    cam->dirty = 1;
+}
+
+void updateCamera(struct Camera *cam) {
+    //cleared first, so a move while building is picked up next call
+    if(!__atomic_exchange_n(&cam->dirty, 0, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+
+    struct CameraBlock block;
+    glm_translate_make(block.view, (vec3){-1 * cam->position[0], cam->position[1], 0.0f});
+
+    //zoom in about the middle of the screen
+    float half_width = 0.5f * SCREEN_WIDTH * cam->zoom / CAMERA_MAX_ZOOM;
+    float half_height = 0.5f * SCREEN_HEIGHT * cam->zoom / CAMERA_MAX_ZOOM;
+    glm_ortho(0.5f * SCREEN_WIDTH - half_width, 0.5f * SCREEN_WIDTH + half_width,
+              0.5f * SCREEN_HEIGHT + half_height, 0.5f * SCREEN_HEIGHT - half_height,
+              -1.0, 1.0, block.projection);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, cam->UBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(struct CameraBlock), &block);
+}
+
+void destroyCamera(struct Camera *cam) {
+    glDeleteBuffers(1, &cam->UBO);
+    cam->UBO = 0;
 }
@@ -2,16 +2,34 @@
 #define CAMERA_H
 
 #include <cglm/cglm.h>
+#include <glad/glad.h>
+
+#include "shader.h"
+#include "const.h"
 
 //consider moving these to a global constants or macros header file
 #define degToRad(deg) ((deg) * M_PI / 180.0)
 #define radToDeg(rad) ((rad) * 180.0 / M_PI)
 
+//zoom limits, CAMERA_MAX_ZOOM shows exactly one screen
+#define CAMERA_MIN_ZOOM 1.0f
+#define CAMERA_MAX_ZOOM 45.0f
+
+//what the uniform block every shader shares holds, in std140 layout
+struct CameraBlock {
+    mat4 view;
+    mat4 projection;
+};
+
 struct Camera {
     vec2 position;
 
     float movement_speed;
     float zoom;
+
+    //uniform buffer behind the shared block, only rewritten when dirty
+    unsigned int UBO;
+    int dirty;
 };
 
 enum camera_movement {
@@ -27,4 +45,13 @@ void translateCamera(struct Camera *cam, enum camera_movement direction, float d
 
 void zoomCamera(struct Camera *cam, float y_offset);
 
+//creates the uniform buffer and binds it to CAMERA_BLOCK_BINDING
+//needs a gl context
+void initCameraBuffer(struct Camera *cam);
+
+//uploads view and projection if the camera moved or zoomed since the last call
+void updateCamera(struct Camera *cam);
+
+void destroyCamera(struct Camera *cam);
+
 #endif
\ No newline at end of file
@@ -5,4 +5,10 @@
 #define SCREEN_WIDTH 1200
 #define SCREEN_HEIGHT 900
 
+// collision speed that fully darkens a circle
+#define DV 10
+
+// extra closing speed added to any collision with an explosive circle
+#define EXPLOSIVE_SPEED 250
+
 #endif
\ No newline at end of file
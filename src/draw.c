@@ -0,0 +1,140 @@
+#include "draw.h"
+
+#define min(x, y) (x < y ? x : y)
+
+// private global circle rendering variables
+static struct SpriteRenderer sprite;
+static struct Shader *shader;
+static struct TextureRegion *circle_tex = 0;
+static struct TextureRegion *rect_tex = 0;
+static struct RenderQueue queue;
+
+// drawObjects draws through a snapshot of its own
+static struct Snapshot frame;
+static struct Budget draw_budget;
+static struct Budget snapshot_budget;
+static int render_index = 0;
+static int snapshot_index = 0;      // render_index for drawSnapshot
+
+// ********** private functions **********
+
+// queues item as a sprite, flushed once a batch ends
+static void drawItem(struct SnapshotItem *item) {
+    struct SpriteInstance *s = addSprite(&sprite, shader, item->rect ? rect_tex : circle_tex);
+    s->x = item->x;
+    s->y = item->y;
+    s->width = item->width;
+    s->height = item->height;
+    s->rotation = 0.0f;
+    s->r = item->r;
+    s->g = item->g;
+    s->b = item->b;
+}
+
+// statics in full, then bodies round robin from index until out of time
+static void drawItems(struct Snapshot *s, float runtime, struct Budget *budget, int *index) {
+    uint64_t start_time = getTicks();
+
+    for(int i = 0; i < s->num_static; i ++) {
+        drawItem(&s->items[i]);
+    }
+
+    int num_bodies = s->count - s->num_static;
+    startBudget(budget, start_time, runtime);
+    int drawn = 0;
+    int batch = 0;
+    while(drawn < num_bodies && (batch = nextBatch(budget, batch)) > 0) {
+        batch = min(batch, num_bodies - drawn);
+        for(int k = 0; k < batch; k ++) {
+            if(*index >= num_bodies) {
+                *index = 0;
+            }
+            drawItem(&s->items[s->num_static + *index]);
+            (*index) ++;
+        }
+        drawn += batch;
+    }
+
+    // the budget counts queueing, drawing is a few calls however many there are
+    flushSprites(&sprite);
+    submitRenderQueue(&queue);
+}
+
+// ********** public functions **********
+
+int initPhysRenderer(struct TexMan *texman, struct Shader *shdr) {
+
+    // set shader
+    shader = shdr;
+
+    // get textures, both land on the same atlas page so they batch together
+    circle_tex = getTextureRegion(texman, "circle");
+    rect_tex = getTextureRegion(texman, "rect");
+    if(circle_tex == 0 || rect_tex == 0) {
+        printf("error loading physics textures\n");
+        exit(1);
+    }
+
+    // intialize sprite renderer
+    initRenderQueue(&queue);
+    initSpriteRenderer(&sprite, &queue);
+
+    initBudget(&draw_budget);
+    initBudget(&snapshot_budget);
+
+    return initPhysics();
+}
+
+int drawObjects(struct List *objects, float runtime) {
+    frame.count = 0;
+    frame.num_static = 0;
+    writeSnapshot(&frame);
+
+    drawItems(&frame, runtime, &draw_budget, &render_index);
+
+    return 0;
+}
+
+// draw this object to the screen
+int drawCircle(struct Circle *c) {
+    drawSprite(&sprite, shader, circle_tex,
+    (vec2){c->pos.x - c->radius, c->pos.y - c->radius},     // position
+    (vec2){c->radius * 2, c->radius * 2},                   // length, width
+    0.0f, (vec3){c->color.x, c->color.y, c->color.z});
+
+    return 0;
+}
+
+int drawRect(struct Rect *r) {
+    drawSprite(&sprite, shader, rect_tex,
+    (vec2){r->pos.x, r->pos.y},     // position
+    (vec2){r->length, r->height},                   // length, width
+    0.0f, (vec3){r->color.x, r->color.y, r->color.z});
+
+    return 0;
+}
+
+int drawSnapshot(struct Snapshot *s, float runtime) {
+    drawItems(s, runtime, &snapshot_budget, &snapshot_index);
+
+    return 0;
+}
+
+int flushObjects() {
+    flushSprites(&sprite);
+    submitRenderQueue(&queue);
+
+    return 0;
+}
+
+void getDrawStats(struct RenderStats *stats) {
+    getRenderStats(&queue, stats);
+}
+
+void destroyPhysRenderer() {
+    destroySpriteRenderer(&sprite);
+    destroyRenderQueue(&queue);
+    free(frame.items);
+    frame.items = 0;
+    frame.capacity = 0;
+}
@@ -0,0 +1,35 @@
+#ifndef DRAW_H
+#define DRAW_H
+
+#include "sprite.h"
+#include "render.h"
+#include "texman.h"
+#include "shader.h"
+#include "snapshot.h"
+#include "phys.h"
+
+// Draws the physics world with sprites.
+// Kept apart from phys.c so the simulation builds without any gl.
+
+// starts the physics too, so call it instead of initPhysics
+int initPhysRenderer(struct TexMan *texman, struct Shader *shdr);
+
+// draws all objecs in list to the screen
+// static geometry is always drawn, bodies round robin for up to runtime seconds
+int drawObjects(struct List *objects, float runtime);
+
+// queued with the world's sprites, drawn by the next drawObjects,
+// drawSnapshot or flushObjects
+int drawCircle(struct Circle *c);
+int drawRect(struct Rect *r);
+int flushObjects();
+
+// same as drawObjects, but only reads a snapshot from writeSnapshot
+int drawSnapshot(struct Snapshot *s, float runtime);
+
+// draw commands and state changes since the last call
+void getDrawStats(struct RenderStats *stats);
+
+void destroyPhysRenderer();
+
+#endif
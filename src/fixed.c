@@ -0,0 +1,37 @@
+#include "fixed.h"
+
+// ********** public functions **********
+
+fixed fxSqrt64(int64_t v) {
+    if(v <= 0) {
+        return 0;
+    }
+
+    // one result bit per round, from the top
+    uint64_t x = v;
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while(bit > x) {
+        bit >>= 2;
+    }
+    while(bit != 0) {
+        if(x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (fixed)root;
+}
+
+uint32_t nextRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
@@ -0,0 +1,32 @@
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdint.h>
+
+// Q16.16 fixed point, for physics that has to come out the same everywhere.
+// Integer math gives the same bits on every machine and compiler, float math
+// depends on how each build rounds and fuses operations.
+// Products go through 64 bits, so one multiply never overflows.
+typedef int32_t fixed;
+
+#define FX_SHIFT 16
+#define FX_ONE (1 << FX_SHIFT)
+
+// multiplying by a power of two is exact, the conversion truncates toward zero
+#define toFixed(f) ((fixed)((f) * FX_ONE))
+#define fixedToFloat(x) ((float)(x) / FX_ONE)
+
+#define fxMul(a, b) ((fixed)(((int64_t)(a) * (b)) / FX_ONE))
+#define fxDiv(a, b) ((fixed)(((int64_t)(a) * FX_ONE) / (b)))
+
+// squared length in Q32.32, big enough for anything on screen
+#define fxLengthSquared(x, y) ((int64_t)(x) * (x) + (int64_t)(y) * (y))
+
+// square root of a Q32.32 value as Q16.16, rounded down
+fixed fxSqrt64(int64_t v);
+
+// xorshift, the same sequence everywhere unlike rand
+// state must not be 0
+uint32_t nextRandom(uint32_t *state);
+
+#endif
@@ -0,0 +1,148 @@
+#include "grid.h"
+
+#include <stdio.h>
+
+// ********** private functions **********
+
+static int hashCell(struct Grid *g, int cx, int cy) {
+    unsigned int h = (unsigned int)cx * 73856093u ^ (unsigned int)cy * 19349663u;
+    return h & (g->table_size - 1);
+}
+
+static int cellCoord(struct Grid *g, float v) {
+    return (int)floorf(v * g->inv_cell_size);
+}
+
+static void *growArray(void *arr, int new_capacity, int elem_size) {
+    void *temp = realloc(arr, new_capacity * elem_size);
+    if(temp == 0) {
+        printf("error allocating memory for grid\n");
+        exit(1);
+    }
+    return temp;
+}
+
+static void pushResult(int id, int n, int **out, int *out_capacity) {
+    if(n >= *out_capacity) {
+        *out_capacity = *out_capacity == 0 ? 64 : *out_capacity * 2;
+        *out = growArray(*out, *out_capacity, sizeof(int));
+    }
+    (*out)[n] = id;
+}
+
+// ********** public functions **********
+
+int initGrid(struct Grid *g) {
+    g->cell_size = 1.0f;
+    g->inv_cell_size = 1.0f;
+    g->table_size = 0;
+    g->buckets = 0;
+    g->next = 0;
+    g->items = 0;
+    g->cell_x = 0;
+    g->cell_y = 0;
+    g->count = 0;
+    g->capacity = 0;
+    g->oversize = 0;
+    g->oversize_count = 0;
+    g->oversize_capacity = 0;
+
+    return 0;
+}
+
+void clearGrid(struct Grid *g, float cell_size, int num_items) {
+    if(cell_size < 1.0f) {
+        cell_size = 1.0f;
+    }
+    g->cell_size = cell_size;
+    g->inv_cell_size = 1.0f / cell_size;
+
+    // keep the load factor at or below one half
+    int table_size = 64;
+    while(table_size < num_items * 2) {
+        table_size *= 2;
+    }
+    if(table_size != g->table_size) {
+        g->table_size = table_size;
+        g->buckets = growArray(g->buckets, table_size, sizeof(int));
+    }
+    for(int i = 0; i < g->table_size; i ++) {
+        g->buckets[i] = -1;
+    }
+
+    g->count = 0;
+    g->oversize_count = 0;
+}
+
+void insertGrid(struct Grid *g, int id, float x, float y, float radius) {
+    // too big for one cell, always reported by queries
+    if(radius * 2 > g->cell_size) {
+        if(g->oversize_count >= g->oversize_capacity) {
+            g->oversize_capacity = g->oversize_capacity == 0 ? 16 : g->oversize_capacity * 2;
+            g->oversize = growArray(g->oversize, g->oversize_capacity, sizeof(int));
+        }
+        g->oversize[g->oversize_count ++] = id;
+        return;
+    }
+
+    if(g->count >= g->capacity) {
+        g->capacity = g->capacity == 0 ? 256 : g->capacity * 2;
+        g->next = growArray(g->next, g->capacity, sizeof(int));
+        g->items = growArray(g->items, g->capacity, sizeof(int));
+        g->cell_x = growArray(g->cell_x, g->capacity, sizeof(int));
+        g->cell_y = growArray(g->cell_y, g->capacity, sizeof(int));
+    }
+
+    int e = g->count ++;
+    int cx = cellCoord(g, x);
+    int cy = cellCoord(g, y);
+    int b = hashCell(g, cx, cy);
+
+    g->items[e] = id;
+    g->cell_x[e] = cx;
+    g->cell_y[e] = cy;
+    g->next[e] = g->buckets[b];
+    g->buckets[b] = e;
+}
+
+int queryGrid(struct Grid *g, float x, float y, float r, int **out, int *out_capacity) {
+    int n = 0;
+
+    // regular items are at most half a cell past the cell holding their center
+    float reach = r + g->cell_size * 0.5f;
+    int min_x = cellCoord(g, x - reach);
+    int max_x = cellCoord(g, x + reach);
+    int min_y = cellCoord(g, y - reach);
+    int max_y = cellCoord(g, y + reach);
+
+    for(int cy = min_y; cy <= max_y; cy ++) {
+        for(int cx = min_x; cx <= max_x; cx ++) {
+            int e = g->buckets[hashCell(g, cx, cy)];
+            while(e != -1) {
+                // different cells can share a bucket, skip them
+                if(g->cell_x[e] == cx && g->cell_y[e] == cy) {
+                    pushResult(g->items[e], n, out, out_capacity);
+                    n ++;
+                }
+                e = g->next[e];
+            }
+        }
+    }
+
+    for(int i = 0; i < g->oversize_count; i ++) {
+        pushResult(g->oversize[i], n, out, out_capacity);
+        n ++;
+    }
+
+    return n;
+}
+
+void destroyGrid(struct Grid *g) {
+    free(g->buckets);
+    free(g->next);
+    free(g->items);
+    free(g->cell_x);
+    free(g->cell_y);
+    free(g->oversize);
+    initGrid(g);
+}
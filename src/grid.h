@@ -0,0 +1,49 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stdlib.h>
+#include <math.h>
+
+// Uniform grid stored as a spatial hash.
+// Items are inserted once by their center point, so the cell size must be
+// at least the diameter of the largest item in the grid. Anything bigger
+// is kept in a separate oversize list that every query returns.
+struct Grid {
+    float cell_size;
+    float inv_cell_size;
+
+    // hash table of chains, -1 terminates a chain
+    int table_size;         // always a power of two
+    int *buckets;
+
+    // one entry per inserted item
+    int *next;
+    int *items;
+    int *cell_x;
+    int *cell_y;
+    int count;
+    int capacity;
+
+    // items too large to be bound by a single cell
+    int *oversize;
+    int oversize_count;
+    int oversize_capacity;
+};
+
+int initGrid(struct Grid *g);
+
+// empties the grid and sets up the table for roughly num_items items
+// cell_size should be the diameter of the largest regular item
+void clearGrid(struct Grid *g, float cell_size, int num_items);
+
+// inserts item id with center x, y and the given radius
+void insertGrid(struct Grid *g, int id, float x, float y, float radius);
+
+// writes the ids of every item that may overlap the circle at x, y with
+// radius r into out, returns how many were found
+// out grows with realloc as needed, out_capacity is updated with it
+int queryGrid(struct Grid *g, float x, float y, float r, int **out, int *out_capacity);
+
+void destroyGrid(struct Grid *g);
+
+#endif
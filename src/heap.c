@@ -0,0 +1,95 @@
+#include "heap.h"
+
+#include <stdio.h>
+
+// ********** private functions **********
+
+static void swapEntries(struct Heap *h, int a, int b) {
+    int item = h->items[a];
+    float key = h->keys[a];
+    h->items[a] = h->items[b];
+    h->keys[a] = h->keys[b];
+    h->items[b] = item;
+    h->keys[b] = key;
+}
+
+// ********** public functions **********
+
+int initHeap(struct Heap *h) {
+    h->items = 0;
+    h->keys = 0;
+    h->count = 0;
+    h->capacity = 0;
+    return 0;
+}
+
+void clearHeap(struct Heap *h) {
+    h->count = 0;
+}
+
+void pushHeap(struct Heap *h, int item, float key) {
+    if(h->count >= h->capacity) {
+        int c = h->capacity == 0 ? 256 : h->capacity * 2;
+        int *items = realloc(h->items, c * sizeof(int));
+        if(items == 0) {
+            printf("error allocating memory for heap\n");
+            exit(1);
+        }
+        h->items = items;
+
+        float *keys = realloc(h->keys, c * sizeof(float));
+        if(keys == 0) {
+            printf("error allocating memory for heap\n");
+            exit(1);
+        }
+        h->keys = keys;
+        h->capacity = c;
+    }
+
+    // sift up
+    int i = h->count ++;
+    h->items[i] = item;
+    h->keys[i] = key;
+    while(i > 0 && h->keys[(i - 1) / 2] < h->keys[i]) {
+        swapEntries(h, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+int popHeap(struct Heap *h) {
+    if(h->count == 0) {
+        return -1;
+    }
+
+    int top = h->items[0];
+    h->count --;
+    h->items[0] = h->items[h->count];
+    h->keys[0] = h->keys[h->count];
+
+    // sift down
+    int i = 0;
+    for(;;) {
+        int largest = i;
+        int l = i * 2 + 1;
+        int r = l + 1;
+        if(l < h->count && h->keys[l] > h->keys[largest]) {
+            largest = l;
+        }
+        if(r < h->count && h->keys[r] > h->keys[largest]) {
+            largest = r;
+        }
+        if(largest == i) {
+            break;
+        }
+        swapEntries(h, i, largest);
+        i = largest;
+    }
+
+    return top;
+}
+
+void destroyHeap(struct Heap *h) {
+    free(h->items);
+    free(h->keys);
+    initHeap(h);
+}
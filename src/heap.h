@@ -0,0 +1,26 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <stdlib.h>
+
+// Binary max heap of ints by float priority.
+struct Heap {
+    int *items;
+    float *keys;
+    int count;
+    int capacity;
+};
+
+int initHeap(struct Heap *h);
+
+// empties the heap, keeping its memory
+void clearHeap(struct Heap *h);
+
+void pushHeap(struct Heap *h, int item, float key);
+
+// removes and returns the item with the highest key, -1 if empty
+int popHeap(struct Heap *h);
+
+void destroyHeap(struct Heap *h);
+
+#endif
@@ -0,0 +1,70 @@
+#include "island.h"
+
+#include <stdio.h>
+
+// ********** public functions **********
+
+int initIslands(struct Islands *is) {
+    is->parent = 0;
+    is->count = 0;
+    is->capacity = 0;
+    return 0;
+}
+
+void clearIslands(struct Islands *is, int n) {
+    if(n > is->capacity) {
+        int c = is->capacity == 0 ? 256 : is->capacity;
+        while(c < n) {
+            c *= 2;
+        }
+        int *temp = realloc(is->parent, c * sizeof(int));
+        if(temp == 0) {
+            printf("error allocating memory for islands\n");
+            exit(1);
+        }
+        is->parent = temp;
+        is->capacity = c;
+    }
+
+    for(int i = 0; i < n; i ++) {
+        is->parent[i] = i;
+    }
+    is->count = n;
+}
+
+void joinIslands(struct Islands *is, int a, int b) {
+    a = findIsland(is, a);
+    b = findIsland(is, b);
+    if(a == b) {
+        return;
+    }
+
+    // lower index becomes the root so the result does not depend on edge order
+    if(a < b) {
+        is->parent[b] = a;
+    }
+    else {
+        is->parent[a] = b;
+    }
+}
+
+int findIsland(struct Islands *is, int i) {
+    int root = i;
+    while(is->parent[root] != root) {
+        root = is->parent[root];
+    }
+
+    // point the whole path straight at the root
+    while(is->parent[i] != root) {
+        int next = is->parent[i];
+        is->parent[i] = root;
+        i = next;
+    }
+
+    return root;
+}
+
+void destroyIslands(struct Islands *is) {
+    free(is->parent);
+    initIslands(is);
+}
@@ -0,0 +1,28 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include <stdlib.h>
+
+// Groups bodies that touch into islands with union find.
+// Edges are collected over a step, then findIsland gives the same root for
+// every body connected through them. Roots are body indices.
+struct Islands {
+    int *parent;
+    int count;
+    int capacity;
+};
+
+int initIslands(struct Islands *is);
+
+// makes every one of the n bodies its own island
+void clearIslands(struct Islands *is, int n);
+
+// joins the islands of bodies a and b
+void joinIslands(struct Islands *is, int a, int b);
+
+// root body of the island containing body i
+int findIsland(struct Islands *is, int i);
+
+void destroyIslands(struct Islands *is);
+
+#endif
@@ -0,0 +1,298 @@
+#include "jobs.h"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+// which queue the current thread pushes to, threads outside the system use 0
+static __thread int worker_index = 0;
+
+// a parallelFor in progress, its jobs claim indices until none are left
+struct ParallelFor {
+    ParallelFunc func;
+    void *arg;
+    int count;
+    int next;
+};
+
+struct WorkerStart {
+    struct Jobs *js;
+    int index;
+};
+
+// ********** private functions **********
+
+// returns 0 if the queue is full
+static int pushQueue(struct JobQueue *q, struct Job *job) {
+    pthread_mutex_lock(&q->lock);
+    if(q->bottom - q->top >= JOB_QUEUE_SIZE) {
+        pthread_mutex_unlock(&q->lock);
+        return 0;
+    }
+    q->jobs[q->bottom % JOB_QUEUE_SIZE] = job;
+    q->bottom ++;
+    pthread_mutex_unlock(&q->lock);
+    return 1;
+}
+
+// newest job, for the owner
+static struct Job *popQueue(struct JobQueue *q) {
+    struct Job *job = 0;
+    pthread_mutex_lock(&q->lock);
+    if(q->bottom > q->top) {
+        q->bottom --;
+        job = q->jobs[q->bottom % JOB_QUEUE_SIZE];
+    }
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+// oldest job, for thieves
+static struct Job *stealQueue(struct JobQueue *q) {
+    struct Job *job = 0;
+    pthread_mutex_lock(&q->lock);
+    if(q->bottom > q->top) {
+        job = q->jobs[q->top % JOB_QUEUE_SIZE];
+        q->top ++;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return job;
+}
+
+static void runJob(struct Jobs *js, struct Job *job);
+
+// queues a job that is ready to run
+static void pushJob(struct Jobs *js, struct Job *job) {
+    if(!pushQueue(&js->queues[worker_index], job)) {
+        // queue is full, running it here still makes progress
+        runJob(js, job);
+        return;
+    }
+
+    // counted under the lock so a worker going to sleep cannot miss it
+    pthread_mutex_lock(&js->lock);
+    __sync_fetch_and_add(&js->queued, 1);
+    pthread_cond_signal(&js->wake);
+    pthread_mutex_unlock(&js->lock);
+}
+
+// own queue first, then the others starting from the next worker
+static struct Job *takeJob(struct Jobs *js) {
+    int self = worker_index;
+    struct Job *job = popQueue(&js->queues[self]);
+
+    for(int k = 1; job == 0 && k < js->num_workers; k ++) {
+        job = stealQueue(&js->queues[(self + k) % js->num_workers]);
+    }
+
+    if(job != 0) {
+        __sync_fetch_and_sub(&js->queued, 1);
+    }
+    return job;
+}
+
+static void runJob(struct Jobs *js, struct Job *job) {
+    job->func(job->arg);
+
+    // the owner may reuse the job once it is done, or once anything
+    // depending on it is, so it is not touched after this
+    struct Job *dependents[JOB_MAX_DEPENDENTS];
+    int num_dependents = job->num_dependents;
+    for(int k = 0; k < num_dependents; k ++) {
+        dependents[k] = job->dependents[k];
+    }
+    __sync_fetch_and_add(&job->done, 1);
+
+    for(int k = 0; k < num_dependents; k ++) {
+        if(__sync_sub_and_fetch(&dependents[k]->pending, 1) == 0) {
+            pushJob(js, dependents[k]);
+        }
+    }
+}
+
+static void *workerMain(void *data) {
+    struct WorkerStart *start = data;
+    struct Jobs *js = start->js;
+    worker_index = start->index;
+    free(start);
+
+    for(;;) {
+        struct Job *job = takeJob(js);
+        if(job != 0) {
+            runJob(js, job);
+            continue;
+        }
+
+        pthread_mutex_lock(&js->lock);
+        while(__sync_fetch_and_add(&js->queued, 0) <= 0 && !js->quit) {
+            pthread_cond_wait(&js->wake, &js->lock);
+        }
+        int quit = js->quit;
+        pthread_mutex_unlock(&js->lock);
+
+        if(quit) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static void forJob(void *arg) {
+    struct ParallelFor *pf = arg;
+    for(;;) {
+        int i = __sync_fetch_and_add(&pf->next, 1);
+        if(i >= pf->count) {
+            break;
+        }
+        pf->func(pf->arg, i);
+    }
+}
+
+// ********** public functions **********
+
+int initJobs(struct Jobs *js, int num_workers) {
+    if(num_workers < 1) {
+        num_workers = 1;
+    }
+    if(num_workers > JOBS_MAX_WORKERS) {
+        num_workers = JOBS_MAX_WORKERS;
+    }
+
+    js->num_workers = num_workers;
+    js->queued = 0;
+    js->quit = 0;
+    pthread_mutex_init(&js->lock, 0);
+    pthread_cond_init(&js->wake, 0);
+
+    js->threads = malloc(num_workers * sizeof(pthread_t));
+    js->queues = malloc(num_workers * sizeof(struct JobQueue));
+    if(js->threads == 0 || js->queues == 0) {
+        printf("error allocating memory for job system\n");
+        exit(1);
+    }
+
+    for(int i = 0; i < num_workers; i ++) {
+        pthread_mutex_init(&js->queues[i].lock, 0);
+        js->queues[i].top = 0;
+        js->queues[i].bottom = 0;
+    }
+
+    for(int i = 1; i < num_workers; i ++) {
+        struct WorkerStart *start = malloc(sizeof(struct WorkerStart));
+        if(start == 0) {
+            printf("error allocating memory for job worker\n");
+            exit(1);
+        }
+        start->js = js;
+        start->index = i;
+
+        if(pthread_create(&js->threads[i], 0, workerMain, start) != 0) {
+            printf("error starting job worker %d\n", i);
+            free(start);
+            js->num_workers = i;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void initJob(struct Job *job, JobFunc func, void *arg) {
+    job->func = func;
+    job->arg = arg;
+    job->pending = 1;
+    job->done = 0;
+    job->num_dependents = 0;
+}
+
+void addJobDependency(struct Job *job, struct Job *before) {
+    if(before->num_dependents >= JOB_MAX_DEPENDENTS) {
+        printf("too many jobs depending on one job\n");
+        exit(1);
+    }
+    before->dependents[before->num_dependents ++] = job;
+    job->pending ++;
+}
+
+void submitJob(struct Jobs *js, struct Job *job) {
+    if(__sync_sub_and_fetch(&job->pending, 1) == 0) {
+        pushJob(js, job);
+    }
+}
+
+void waitJob(struct Jobs *js, struct Job *job) {
+    while(!__sync_fetch_and_add(&job->done, 0)) {
+        struct Job *other = takeJob(js);
+        if(other != 0) {
+            runJob(js, other);
+        }
+        else {
+            // whatever we wait on is running somewhere else
+            sched_yield();
+        }
+    }
+}
+
+void parallelFor(struct Jobs *js, int width, ParallelFunc func, void *arg, int count) {
+    if(width > js->num_workers) {
+        width = js->num_workers;
+    }
+    if(width > count) {
+        width = count;
+    }
+
+    // not worth waking anybody
+    if(width <= 1) {
+        for(int i = 0; i < count; i ++) {
+            func(arg, i);
+        }
+        return;
+    }
+
+    struct ParallelFor pf = {func, arg, count, 0};
+    struct Job jobs[JOBS_MAX_WORKERS];
+    for(int k = 0; k < width; k ++) {
+        initJob(&jobs[k], forJob, &pf);
+        submitJob(js, &jobs[k]);
+    }
+    for(int k = 0; k < width; k ++) {
+        waitJob(js, &jobs[k]);
+    }
+}
+
+void destroyJobs(struct Jobs *js) {
+    pthread_mutex_lock(&js->lock);
+    js->quit = 1;
+    pthread_cond_broadcast(&js->wake);
+    pthread_mutex_unlock(&js->lock);
+
+    for(int i = 1; i < js->num_workers; i ++) {
+        pthread_join(js->threads[i], 0);
+    }
+
+    for(int i = 0; i < js->num_workers; i ++) {
+        pthread_mutex_destroy(&js->queues[i].lock);
+    }
+    free(js->threads);
+    free(js->queues);
+    pthread_mutex_destroy(&js->lock);
+    pthread_cond_destroy(&js->wake);
+}
+
+int getCoreCount() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int n = info.dwNumberOfProcessors;
+#else
+    int n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return n < 1 ? 1 : n;
+}
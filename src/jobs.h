@@ -0,0 +1,80 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <pthread.h>
+
+// most threads a job system will start, and most jobs one parallelFor splits into
+#define JOBS_MAX_WORKERS 64
+
+// jobs one worker can have queued, more than this run right away
+#define JOB_QUEUE_SIZE 256
+
+// jobs that can wait on one job
+#define JOB_MAX_DEPENDENTS 8
+
+typedef void (*JobFunc)(void *arg);
+
+// work function for parallelFor, called once for every index below count
+typedef void (*ParallelFunc)(void *arg, int index);
+
+// One piece of work, owned by whoever submits it.
+// It must stay alive until it is done, which waitJob on it or on
+// anything depending on it makes sure of.
+struct Job {
+    JobFunc func;
+    void *arg;
+    int pending;            // unfinished dependencies, plus one until submitted
+    int done;
+    struct Job *dependents[JOB_MAX_DEPENDENTS];
+    int num_dependents;
+};
+
+// a worker's deque, it pushes and pops at the bottom, thieves take from the top
+struct JobQueue {
+    pthread_mutex_t lock;
+    struct Job *jobs[JOB_QUEUE_SIZE];
+    int top;
+    int bottom;
+};
+
+// Work stealing job system.
+// Every worker has its own queue and steals from the others when it runs dry.
+// The thread that called initJobs is worker 0, it only runs jobs while
+// waiting on one, so anything that must stay on that thread can.
+struct Jobs {
+    pthread_t *threads;
+    struct JobQueue *queues;
+    int num_workers;
+
+    // idle workers sleep here until something is queued
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int queued;
+    int quit;
+};
+
+// starts num_workers - 1 threads, returns 0 on success
+int initJobs(struct Jobs *js, int num_workers);
+
+void initJob(struct Job *job, JobFunc func, void *arg);
+
+// job will not start before before has finished
+// must be called before either of them is submitted
+void addJobDependency(struct Job *job, struct Job *before);
+
+// queues job on the calling worker once its dependencies are done
+void submitJob(struct Jobs *js, struct Job *job);
+
+// runs other jobs until job is done
+void waitJob(struct Jobs *js, struct Job *job);
+
+// runs func(arg, i) for every i in [0, count) split across at most width jobs
+// and returns once all of them are done, indices are claimed in increasing order
+void parallelFor(struct Jobs *js, int width, ParallelFunc func, void *arg, int count);
+
+void destroyJobs(struct Jobs *js);
+
+// number of cores the system has online, at least 1
+int getCoreCount();
+
+#endif
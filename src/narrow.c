@@ -0,0 +1,255 @@
+#include "narrow.h"
+#include "phys.h"
+
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+int narrowCircCircScalar(struct Bodies *bodies, const int *a, const int *b, int n, struct Manifold *out) {
+    int count = 0;
+
+    for(int k = 0; k < n; k ++) {
+        int i = a[k];
+        int j = b[k];
+
+        if(bodies->inv_mass[i] == 0 && bodies->inv_mass[j] == 0) {
+            continue;
+        }
+
+        // vector from a to b
+        float dx = bodies->pos_x[j] - bodies->pos_x[i];
+        float dy = bodies->pos_y[j] - bodies->pos_y[i];
+        float r = bodies->radius[i] + bodies->radius[j];
+        float d2 = dx * dx + dy * dy;
+
+        if(d2 > r * r) {
+            continue;
+        }
+
+        struct Manifold *m = &out[count ++];
+        m->a = i;
+        m->b = j;
+
+        float d = sqrtf(d2);
+        if(d != 0) {
+            m->penetration = r - d;
+            m->norm.x = dx / d;
+            m->norm.y = dy / d;
+        }
+        else {
+            // circles are directly on top of eachother, just pick something
+            m->penetration = bodies->radius[i];
+            m->norm.x = 1.0f;
+            m->norm.y = 0.0f;
+        }
+    }
+
+    return count;
+}
+
+int narrowCircRectScalar(struct Bodies *bodies, const int *a, int n, struct Rect *rects, int r, struct Manifold *out) {
+    int count = 0;
+
+    for(int k = 0; k < n; k ++) {
+        struct Manifold *m = &out[count];
+        m->a = a[k];
+        m->b = r;
+        if(isCollidingCircVRect(bodies, m, &rects[r])) {
+            count ++;
+        }
+    }
+
+    return count;
+}
+
+#ifdef __SSE2__
+
+int narrowCircCirc(struct Bodies *bodies, const int *a, const int *b, int n, struct Manifold *out) {
+    float *px = bodies->pos_x;
+    float *py = bodies->pos_y;
+    float *rad = bodies->radius;
+    float *im = bodies->inv_mass;
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    int count = 0;
+    int k = 0;
+
+    for(; k + 4 <= n; k += 4) {
+        int i0 = a[k], i1 = a[k + 1], i2 = a[k + 2], i3 = a[k + 3];
+        int j0 = b[k], j1 = b[k + 1], j2 = b[k + 2], j3 = b[k + 3];
+
+        // gather, lane order matches pair order
+        __m128 ax = _mm_setr_ps(px[i0], px[i1], px[i2], px[i3]);
+        __m128 ay = _mm_setr_ps(py[i0], py[i1], py[i2], py[i3]);
+        __m128 ar = _mm_setr_ps(rad[i0], rad[i1], rad[i2], rad[i3]);
+        __m128 am = _mm_setr_ps(im[i0], im[i1], im[i2], im[i3]);
+        __m128 bx = _mm_setr_ps(px[j0], px[j1], px[j2], px[j3]);
+        __m128 by = _mm_setr_ps(py[j0], py[j1], py[j2], py[j3]);
+        __m128 br = _mm_setr_ps(rad[j0], rad[j1], rad[j2], rad[j3]);
+        __m128 bm = _mm_setr_ps(im[j0], im[j1], im[j2], im[j3]);
+
+        __m128 dx = _mm_sub_ps(bx, ax);
+        __m128 dy = _mm_sub_ps(by, ay);
+        __m128 r = _mm_add_ps(ar, br);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+
+        // overlapping and at least one of them moves
+        __m128 hit = _mm_cmple_ps(d2, _mm_mul_ps(r, r));
+        __m128 both_static = _mm_and_ps(_mm_cmpeq_ps(am, zero), _mm_cmpeq_ps(bm, zero));
+        hit = _mm_andnot_ps(both_static, hit);
+
+        int mask = _mm_movemask_ps(hit);
+        if(mask == 0) {
+            continue;
+        }
+
+        __m128 d = _mm_sqrt_ps(d2);
+        __m128 same = _mm_cmpeq_ps(d, zero);
+        // divide by one in coincident lanes, then overwrite them below
+        __m128 safe_d = _mm_or_ps(_mm_and_ps(same, one), _mm_andnot_ps(same, d));
+
+        __m128 pen = _mm_sub_ps(r, d);
+        __m128 nx = _mm_div_ps(dx, safe_d);
+        __m128 ny = _mm_div_ps(dy, safe_d);
+
+        // coincident circles get a fixed normal and the first radius as depth
+        pen = _mm_or_ps(_mm_and_ps(same, ar), _mm_andnot_ps(same, pen));
+        nx = _mm_or_ps(_mm_and_ps(same, one), _mm_andnot_ps(same, nx));
+        ny = _mm_andnot_ps(same, ny);
+
+        float pen_out[4], nx_out[4], ny_out[4];
+        _mm_storeu_ps(pen_out, pen);
+        _mm_storeu_ps(nx_out, nx);
+        _mm_storeu_ps(ny_out, ny);
+
+        // compact the hits into the contact buffer
+        for(int lane = 0; lane < 4; lane ++) {
+            if(mask & (1 << lane)) {
+                struct Manifold *m = &out[count ++];
+                m->a = a[k + lane];
+                m->b = b[k + lane];
+                m->penetration = pen_out[lane];
+                m->norm.x = nx_out[lane];
+                m->norm.y = ny_out[lane];
+            }
+        }
+    }
+
+    // leftover pairs
+    count += narrowCircCircScalar(bodies, a + k, b + k, n - k, out + count);
+
+    return count;
+}
+
+int narrowCircRect(struct Bodies *bodies, const int *a, int n, struct Rect *rects, int r, struct Manifold *out) {
+    const float *px = bodies->pos_x;
+    const float *py = bodies->pos_y;
+    const float *rad = bodies->radius;
+
+    // the rect is the same in every lane
+    const __m128 rx = _mm_set1_ps(rects[r].pos.x);
+    const __m128 ry = _mm_set1_ps(rects[r].pos.y);
+    const __m128 rl = _mm_set1_ps(rects[r].length);
+    const __m128 rh = _mm_set1_ps(rects[r].height);
+    const __m128 right = _mm_add_ps(rx, rl);
+    const __m128 bottom = _mm_add_ps(ry, rh);
+    const __m128 tiny = _mm_set1_ps(0.000000001f);
+    const __m128 fallback = _mm_set1_ps(0.0001f);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+
+    int count = 0;
+    int k = 0;
+
+    for(; k + 4 <= n; k += 4) {
+        int i0 = a[k], i1 = a[k + 1], i2 = a[k + 2], i3 = a[k + 3];
+
+        // gather, lane order matches body order
+        __m128 x = _mm_setr_ps(px[i0], px[i1], px[i2], px[i3]);
+        __m128 y = _mm_setr_ps(py[i0], py[i1], py[i2], py[i3]);
+        __m128 radius = _mm_setr_ps(rad[i0], rad[i1], rad[i2], rad[i3]);
+
+        // closest point on the rect to the circle center
+        __m128 cx = _mm_min_ps(_mm_max_ps(x, rx), right);
+        __m128 cy = _mm_min_ps(_mm_max_ps(y, ry), bottom);
+        __m128 inside = _mm_and_ps(_mm_cmpeq_ps(cx, x), _mm_cmpeq_ps(cy, y));
+
+        // distances to each edge, only used for centers inside the rect
+        __m128 dtl = _mm_sub_ps(x, rx);
+        __m128 dtr = _mm_sub_ps(rl, dtl);
+        __m128 dtt = _mm_sub_ps(y, ry);
+        __m128 dtb = _mm_sub_ps(rh, dtt);
+
+        // same priority as the scalar chain: left, right, top, bottom
+        __m128 use_l = _mm_and_ps(_mm_cmplt_ps(dtl, dtr), _mm_and_ps(_mm_cmplt_ps(dtl, dtt), _mm_cmplt_ps(dtl, dtb)));
+        __m128 use_r = _mm_andnot_ps(use_l, _mm_and_ps(_mm_cmplt_ps(dtr, dtt), _mm_cmplt_ps(dtr, dtb)));
+        __m128 use_x = _mm_or_ps(use_l, use_r);
+        __m128 use_t = _mm_andnot_ps(use_x, _mm_cmplt_ps(dtt, dtb));
+        __m128 use_b = _mm_andnot_ps(_mm_or_ps(use_x, use_t), inside);
+        use_l = _mm_and_ps(use_l, inside);
+        use_r = _mm_and_ps(use_r, inside);
+        use_t = _mm_and_ps(use_t, inside);
+
+        cx = _mm_or_ps(_mm_andnot_ps(_mm_or_ps(use_l, use_r), cx),
+                _mm_or_ps(_mm_and_ps(use_l, rx), _mm_and_ps(use_r, right)));
+        cy = _mm_or_ps(_mm_andnot_ps(_mm_or_ps(use_t, use_b), cy),
+                _mm_or_ps(_mm_and_ps(use_t, ry), _mm_and_ps(use_b, bottom)));
+
+        __m128 nx = _mm_sub_ps(cx, x);
+        __m128 ny = _mm_sub_ps(cy, y);
+        __m128 d2 = _mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny));
+
+        __m128 hit = _mm_or_ps(inside, _mm_cmple_ps(d2, _mm_mul_ps(radius, radius)));
+        int mask = _mm_movemask_ps(hit);
+        if(mask == 0) {
+            continue;
+        }
+
+        __m128 d = _mm_sqrt_ps(d2);
+        __m128 small = _mm_cmplt_ps(d, tiny);
+        d = _mm_or_ps(_mm_and_ps(small, fallback), _mm_andnot_ps(small, d));
+
+        // the normal points out of the rect when the center is inside it
+        __m128 flip = _mm_and_ps(inside, sign);
+        nx = _mm_xor_ps(_mm_div_ps(nx, d), flip);
+        ny = _mm_xor_ps(_mm_div_ps(ny, d), flip);
+        __m128 pen = _mm_sub_ps(radius, d);
+
+        float pen_out[4], nx_out[4], ny_out[4];
+        _mm_storeu_ps(pen_out, pen);
+        _mm_storeu_ps(nx_out, nx);
+        _mm_storeu_ps(ny_out, ny);
+
+        // compact the hits into the contact buffer
+        for(int lane = 0; lane < 4; lane ++) {
+            if(mask & (1 << lane)) {
+                struct Manifold *m = &out[count ++];
+                m->a = a[k + lane];
+                m->b = r;
+                m->penetration = pen_out[lane];
+                m->norm.x = nx_out[lane];
+                m->norm.y = ny_out[lane];
+            }
+        }
+    }
+
+    // leftover bodies
+    count += narrowCircRectScalar(bodies, a + k, n - k, rects, r, out + count);
+
+    return count;
+}
+
+#else
+
+int narrowCircCirc(struct Bodies *bodies, const int *a, const int *b, int n, struct Manifold *out) {
+    return narrowCircCircScalar(bodies, a, b, n, out);
+}
+
+int narrowCircRect(struct Bodies *bodies, const int *a, int n, struct Rect *rects, int r, struct Manifold *out) {
+    return narrowCircRectScalar(bodies, a, n, rects, r, out);
+}
+
+#endif
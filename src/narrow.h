@@ -0,0 +1,29 @@
+#ifndef NARROW_H
+#define NARROW_H
+
+#include "bodies.h"
+
+struct Manifold;
+struct Rect;
+
+// Batched narrow phase kernels.
+// Pair k is (a[k], b[k]), both indices into bodies. Colliding pairs are
+// written to out in pair order as compact contacts, and the number of
+// contacts is returned. out must have room for n contacts.
+// Pairs where neither body can move are never reported.
+
+// circle against circle, one pair at a time in float
+int narrowCircCircScalar(struct Bodies *bodies, const int *a, const int *b, int n, struct Manifold *out);
+
+// circle against circle, 4 pairs per instruction with SSE
+// falls back to the scalar kernel when SSE2 is not available
+int narrowCircCirc(struct Bodies *bodies, const int *a, const int *b, int n, struct Manifold *out);
+
+// the n bodies listed in a against rects[r], b of each contact is r
+// the callers group their pairs by rect so one rect fills all four lanes
+int narrowCircRectScalar(struct Bodies *bodies, const int *a, int n, struct Rect *rects, int r, struct Manifold *out);
+
+// circles against one rect, 4 bodies per instruction with no branches
+int narrowCircRect(struct Bodies *bodies, const int *a, int n, struct Rect *rects, int r, struct Manifold *out);
+
+#endif
@@ -1,16 +1,31 @@
 
 #include "phys.h"
 
+#include <stdio.h>
+#include <string.h>
+
 #define min(x, y) (x < y ? x : y)
 #define max(x, y) (!min(x, y))
 #define clamp(a, min, max) ((a < min ? min : a) == (a > max ? max : a) ? a : (a < min ? min : max))
 
-// private global circle rendering variables
-static struct SpriteRenderer sprite;
-static struct Shader *shader;
-static int circle_tex_id = 0;
-static int rect_tex_id = 0;
-static int renderer_initialized = 0;
+static int physics_initialized = 0;
+
+// sweep and prune bounds cover where circles will move during a call,
+// padded by at least SAP_MARGIN, more after circles escaped them
+#define SAP_MARGIN 2.0f
+#define SAP_MARGIN_DECAY 0.9f
+
+// static distance field resolution, band must cover the largest radius
+#define SDF_CELL_SIZE 4.0f
+#define SDF_BAND 32.0f
+
+// the most fixed steps one call may take to catch up
+#define MAX_SUBSTEPS 4
+
+// a body that stays within SLEEP_DISTANCE of where it was for SLEEP_TIME
+// seconds may sleep with its island
+#define SLEEP_DISTANCE 2.0f
+#define SLEEP_TIME 0.5f
 
 // Always present forces
 static float gravity = 80;
@@ -21,240 +36,2158 @@ float distSquared(float x1, float y1, float x2, float y2);
 float lengthV2(struct v2 *v);
 float lengthV2Squared(struct v2 *v);
 
+// moving circles
+static struct Bodies bodies;
+
 // static states
-struct Node *render_node = 0;
-struct Node *phys_node = 0;
+static int phys_index = 0;
+
+// each loop over the bodies learns its own cost per body
+static struct Budget visit_budget;
+
+// broadphase state
+static int broadphase = BROADPHASE_LIST;
+static struct Grid grid;
+static int grid_initialized = 0;
+static struct Sap sap;
+static int sap_initialized = 0;
+static int *sap_body = 0;       // body index of each sap proxy
+static int sap_body_capacity = 0;
+static float sap_margin = SAP_MARGIN;
+static float sap_needed = 0;    // margin that would have kept every circle in its bounds
+static int sap_stale = 0;       // a circle left its proxy bounds since the last sync
+static float grid_moved = 0;    // furthest any circle has got from where the grid has it
+static int *removed = 0;
+static int removed_capacity = 0;
+
+// fixed timestep state
+static int step_mode = STEP_VARIABLE;
+static float accumulator = 0;
+static uint64_t last_step_time = UINT64_MAX;   // ticks, UINT64_MAX before the first step
+static uint64_t step_end = 0;       // ticks the bodies are being stepped to
+
+// STEP_DETERMINISTIC state, everything it decides on is integer math
+#define FX_DT toFixed(FIXED_DT)
+#define SLEEP_STEPS ((int)(SLEEP_TIME / FIXED_DT + 0.5f))
+#define FX_SLOP toFixed(0.01f)          // penetration left alone
+#define FX_PERCENT toFixed(0.8f)        // share of the rest corrected each step
+static uint64_t phys_tick = 0;
+static TickFunc tick_func = 0;
+static void *tick_arg = 0;
+static float interp_alpha = 1.0f;   // how far drawing is between prev and pos
+
+// sequential impulse solver, used by fixed steps unless SOLVER_IMMEDIATE
+static int solver_mode = SOLVER_IMMEDIATE;
+static int solver_iterations = 8;
+static struct Solver solver;
+static int solving = 0;             // contacts go to the solver instead of straight to response
+
+// job system for collision and SOLVER_PARALLEL
+// shared with the main loop through setPhysJobs, or started here on first use
+static struct Jobs *jobs = 0;
+static struct Jobs own_jobs;
+static int phys_threads = 1;        // most jobs one loop is split into
+
+// contact islands, rebuilt every pass
+static struct Islands islands;
+static float *island_still = 0;     // shortest sleep_time in each island, by root
+static int island_still_capacity = 0;
+// sleeping islands a contact woke a body of this pass, the rest follow in updateSleep
+static int *woken_islands = 0;
+static int num_woken_islands = 0;
+static int woken_islands_capacity = 0;
+
+// contacts found for a run of bodies, each run fills its own
+// nothing shared is written while gathering, so runs can be gathered in parallel
+struct Gather {
+    // scratch
+    int *candidates;
+    int candidates_capacity;
+    int *pair_a;
+    int *pair_b;
+    int pair_a_capacity;
+    int pair_b_capacity;
+    int *static_candidates;
+    int static_candidates_capacity;
+
+    // static rect pairs, tested later grouped by rect
+    int *rect_pair_body;
+    int *rect_pair_rect;
+    int num_rect_pairs;
+    int rect_pair_body_capacity;
+    int rect_pair_rect_capacity;
+
+    // contacts in the order they were found
+    struct Manifold *found;
+    char *found_static;     // 1 if the contact is against static geometry
+    int num_found;
+    int found_capacity;
+    int found_static_capacity;
+
+    unsigned long pair_tests;
+};
+
+// bodies per gather run
+#define GATHER_BLOCK 32
+
+// one gather per run, the serial pair loop only uses the first
+static struct Gather *gathers = 0;
+static int gathers_capacity = 0;
+static int *gather_list = 0;        // bodies to gather, in order
+static int gather_list_capacity = 0;
+// position of each body in gather_list, -1 if it gathers nothing this pass
+static int *gather_rank = 0;
+static int gather_rank_capacity = 0;
+static int gathering = 0;           // every body in gather_list gathers before any response
+
+// level of detail for SCHEDULE_LOD, bodies within LOD_NEAR of a focus run
+// at full rate, each level past that reaches twice as far at half the rate
+#define LOD_NEAR 200.0f
+#define LOD_LEVELS 4
+static int schedule = SCHEDULE_ROUND_ROBIN;
+static struct Node *focus_node = 0;
+static int focus_point_set = 0;
+static float focus_x = 0;
+static float focus_y = 0;
+static int *lod_level = 0;          // level of each body this pass, -1 if not due
+static int lod_level_capacity = 0;
+static int lod_pass = 0;            // a SCHEDULE_LOD pass is running, lod_level is current
+
+// SCHEDULE_STALEST visits bodies by how long they have waited, times
+// 1 + stale_speed_weight * speed, popped from the heap as they are needed
+static struct Heap stale_heap;
+static float stale_speed_weight = 0;
+static int num_scheduled = 0;       // how much of gather_list has been filled in
+
+// artificial load per pair test, used by the scheduling experiments
+static int pair_work = 2000;
+
+static struct PhysStats stats;
+
+// static geometry, kept out of the object list
+// ids in the bvh are index << 1 | 1 for rects, index << 1 for circles
+// removed bodies keep their slot so ids stay valid
+static struct Rect *static_rects = 0;
+static char *static_rect_alive = 0;
+static int num_static_rects = 0;
+static int static_rects_capacity = 0;
+static struct Circle *static_circles = 0;
+static char *static_circle_alive = 0;
+static int num_static_circles = 0;
+static int static_circles_capacity = 0;
+static struct Bvh static_bvh;
+static int static_dirty = 1;
+
+// optional baked distance field over the static geometry
+static int static_collision = STATIC_ANALYTIC;
+static struct Sdf static_sdf;
+static int sdf_baked = 0;
+static int *static_candidates = 0;     // scratch for removeStatic
+static int static_candidates_capacity = 0;
+
+// static rect pairs of one call, grouped by rect before the narrow phase
+// each rect's contacts go in contacts at the offset of its first pair
+static int *rect_start = 0;
+static int rect_start_capacity = 0;
+static int *rect_bodies = 0;
+static int rect_bodies_capacity = 0;
+static int *rect_found = 0;         // contacts each rect found
+static int rect_found_capacity = 0;
+static struct Manifold *contacts = 0;
+static int contacts_capacity = 0;
+static uint64_t last_static_update = 0;
+
+int initPhysics() {
+    initBodies(&bodies);
+    initIslands(&islands);
+    initSolver(&solver);
+    initHeap(&stale_heap);
+    initBudget(&visit_budget);
+
+    physics_initialized = 1;
+    return 0;
+}
+
+// initialize this game object
+struct Node *addCircle(struct List *objects, float x, float y, float xv, float yv, float radius, float mass) {
+    if(physics_initialized == 0) {
+        return 0;
+    }
+
+    int i = addBody(&bodies);
+
+    bodies.pos_x[i] = x;
+    bodies.pos_y[i] = y;
+    bodies.prev_x[i] = x;
+    bodies.prev_y[i] = y;
+    bodies.grid_x[i] = x;
+    bodies.grid_y[i] = y;
+    bodies.vel_x[i] = xv;
+    bodies.vel_y[i] = yv;
+    bodies.fx_pos_x[i] = toFixed(x);
+    bodies.fx_pos_y[i] = toFixed(y);
+    bodies.fx_vel_x[i] = toFixed(xv);
+    bodies.fx_vel_y[i] = toFixed(yv);
+    bodies.explosive[i] = 0;
+
+    bodies.radius[i] = radius;
+
+    bodies.mass[i] = mass;
+    if(mass == 0) {
+        bodies.inv_mass[i] = 0;
+    }
+    else {
+        bodies.inv_mass[i] = 1 / mass;
+    }
+    bodies.restitution[i] = 0.7;
+
+    bodies.last_update_time[i] = getFrameTicks();
+
+    // spread bodies on the same level over different passes
+    bodies.skipped[i] = bodies.id[i] % (1 << (LOD_LEVELS - 1));
+
+    // the node is only a handle, its data is the body index
+    bodies.node[i] = insertNode(objects, &i, sizeof(int), CIRC_TYPE);
+
+    return bodies.node[i];
+}
+
+void translateCircle(struct Node *node, float dx, float dy) {
+    int i = bodyIndex(node);
+    if(step_mode == STEP_DETERMINISTIC) {
+        bodies.fx_pos_x[i] += toFixed(dx);
+        bodies.fx_pos_y[i] += toFixed(dy);
+        bodies.pos_x[i] = fixedToFloat(bodies.fx_pos_x[i]);
+        bodies.pos_y[i] = fixedToFloat(bodies.fx_pos_y[i]);
+    }
+    else {
+        bodies.pos_x[i] += dx;
+        bodies.pos_y[i] += dy;
+    }
+}
+
+void setCircleExplosive(struct Node *node, int explosive) {
+    bodies.explosive[bodyIndex(node)] = explosive;
+}
+
+static void buildStatics();
+
+// add a rectangle that never moves
+int addRect(float x, float y, float l, float h) {
+    if(physics_initialized == 0) {
+        return -1;
+    }
+
+    if(num_static_rects >= static_rects_capacity) {
+        static_rects_capacity = static_rects_capacity == 0 ? 16 : static_rects_capacity * 2;
+        static_rects = realloc(static_rects, static_rects_capacity * sizeof(struct Rect));
+        static_rect_alive = realloc(static_rect_alive, static_rects_capacity);
+        if(static_rects == 0 || static_rect_alive == 0) {
+            printf("error allocating memory for static rects\n");
+            exit(1);
+        }
+    }
+
+    int index = num_static_rects ++;
+    struct Rect *r = &static_rects[index];
+    static_rect_alive[index] = 1;
+
+    r->pos.x = x;
+    r->pos.y = y;
+    r->length = l;
+    r->height = h;
+    r->color.x = 1.0f;
+    r->color.y = 1.0f;
+    r->color.z = 1.0f;
+    r->restitution = 1;
+
+    static_dirty = 1;
+    if(sdf_baked) {
+        addSdfRect(&static_sdf, x, y, l, h);
+    }
+
+    return index << 1 | 1;
+}
+
+// add a circle that never moves
+int addStaticCircle(float x, float y, float radius) {
+    if(physics_initialized == 0) {
+        return -1;
+    }
+
+    if(num_static_circles >= static_circles_capacity) {
+        static_circles_capacity = static_circles_capacity == 0 ? 16 : static_circles_capacity * 2;
+        static_circles = realloc(static_circles, static_circles_capacity * sizeof(struct Circle));
+        static_circle_alive = realloc(static_circle_alive, static_circles_capacity);
+        if(static_circles == 0 || static_circle_alive == 0) {
+            printf("error allocating memory for static circles\n");
+            exit(1);
+        }
+    }
+
+    int index = num_static_circles ++;
+    struct Circle *c = &static_circles[index];
+    static_circle_alive[index] = 1;
+
+    c->pos.x = x;
+    c->pos.y = y;
+    c->radius = radius;
+    c->color.x = 1.0f;
+    c->color.y = 1.0f;
+    c->color.z = 1.0f;
+    c->restitution = 0.7;
+
+    static_dirty = 1;
+    if(sdf_baked) {
+        addSdfCircle(&static_sdf, x, y, radius);
+    }
+
+    return index << 1;
+}
+
+// box around a static body, grown by pad on every side
+static void staticBounds(int id, float pad, float *b) {
+    if(id & 1) {
+        struct Rect *r = &static_rects[id >> 1];
+        b[0] = r->pos.x - pad;
+        b[1] = r->pos.y - pad;
+        b[2] = r->pos.x + r->length + pad;
+        b[3] = r->pos.y + r->height + pad;
+    }
+    else {
+        struct Circle *c = &static_circles[id >> 1];
+        b[0] = c->pos.x - c->radius - pad;
+        b[1] = c->pos.y - c->radius - pad;
+        b[2] = c->pos.x + c->radius + pad;
+        b[3] = c->pos.y + c->radius + pad;
+    }
+}
+
+static void addStaticToSdf(int id) {
+    if(id & 1) {
+        struct Rect *r = &static_rects[id >> 1];
+        addSdfRect(&static_sdf, r->pos.x, r->pos.y, r->length, r->height);
+    }
+    else {
+        struct Circle *c = &static_circles[id >> 1];
+        addSdfCircle(&static_sdf, c->pos.x, c->pos.y, c->radius);
+    }
+}
+
+// remove a body returned by addRect or addStaticCircle
+int removeStatic(int id) {
+    int index = id >> 1;
+    if(id < 0 || ((id & 1) && (index >= num_static_rects || !static_rect_alive[index]))
+        || (!(id & 1) && (index >= num_static_circles || !static_circle_alive[index]))) {
+        return 1;
+    }
+
+    if(id & 1) {
+        static_rect_alive[index] = 0;
+    }
+    else {
+        static_circle_alive[index] = 0;
+    }
+    static_dirty = 1;
+
+    // clear everything the body could have been closest to,
+    // then merge back whatever else reaches into that area
+    if(sdf_baked) {
+        float b[4];
+        staticBounds(id, static_sdf.band, b);
+        clearSdf(&static_sdf, b[0], b[1], b[2], b[3]);
+
+        buildStatics();
+        int n = queryBvh(&static_bvh, b[0] - static_sdf.band, b[1] - static_sdf.band,
+            b[2] + static_sdf.band, b[3] + static_sdf.band, &static_candidates, &static_candidates_capacity);
+        for(int i = 0; i < n; i ++) {
+            addStaticToSdf(static_candidates[i]);
+        }
+    }
+
+    return 0;
+}
+
+// bakes every static body into a fresh distance field
+static void bakeStatics() {
+    if(!sdf_baked) {
+        initSdf(&static_sdf, SCREEN_WIDTH, SCREEN_HEIGHT, SDF_CELL_SIZE, SDF_BAND);
+        sdf_baked = 1;
+    }
+    else {
+        clearSdf(&static_sdf, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    }
+
+    for(int i = 0; i < num_static_rects; i ++) {
+        if(static_rect_alive[i]) {
+            addStaticToSdf(i << 1 | 1);
+        }
+    }
+    for(int i = 0; i < num_static_circles; i ++) {
+        if(static_circle_alive[i]) {
+            addStaticToSdf(i << 1);
+        }
+    }
+}
+
+// rebuilds the bvh over all static bodies
+static void buildStatics() {
+    int n = 0;
+    float *bounds = malloc(((num_static_rects + num_static_circles) * 4 + 1) * sizeof(float));
+    int *ids = malloc((num_static_rects + num_static_circles + 1) * sizeof(int));
+    if(bounds == 0 || ids == 0) {
+        printf("error allocating memory for static bounds\n");
+        exit(1);
+    }
+
+    for(int i = 0; i < num_static_rects; i ++) {
+        if(static_rect_alive[i]) {
+            ids[n] = i << 1 | 1;
+            staticBounds(ids[n], 0, &bounds[n * 4]);
+            n ++;
+        }
+    }
+    for(int i = 0; i < num_static_circles; i ++) {
+        if(static_circle_alive[i]) {
+            ids[n] = i << 1;
+            staticBounds(ids[n], 0, &bounds[n * 4]);
+            n ++;
+        }
+    }
+
+    buildBvh(&static_bvh, bounds, ids, n);
+    static_dirty = 0;
+
+    // something may have been resting on what changed
+    for(int i = 0; i < bodies.count; i ++) {
+        bodies.sleeping[i] = 0;
+        bodies.sleep_time[i] = 0;
+        bodies.sleep_island[i] = -1;
+    }
+
+    free(bounds);
+    free(ids);
+}
+
+static void snapshotCircle(struct Snapshot *s, float x, float y, float radius, float r, float g, float b) {
+    struct SnapshotItem *item = addSnapshotItem(s);
+    item->x = x - radius;
+    item->y = y - radius;
+    item->width = radius * 2;
+    item->height = radius * 2;
+    item->r = r;
+    item->g = g;
+    item->b = b;
+    item->rect = 0;
+}
+
+// copies everything there is to draw into s, statics first
+// bodies are placed between their last two steps by interp_alpha
+void writeSnapshot(struct Snapshot *s) {
+    for(int i = 0; i < num_static_rects; i ++) {
+        if(static_rect_alive[i]) {
+            struct Rect *r = &static_rects[i];
+            struct SnapshotItem *item = addSnapshotItem(s);
+            item->x = r->pos.x;
+            item->y = r->pos.y;
+            item->width = r->length;
+            item->height = r->height;
+            item->r = r->color.x;
+            item->g = r->color.y;
+            item->b = r->color.z;
+            item->rect = 1;
+        }
+    }
+    for(int i = 0; i < num_static_circles; i ++) {
+        if(static_circle_alive[i]) {
+            struct Circle *c = &static_circles[i];
+            snapshotCircle(s, c->pos.x, c->pos.y, c->radius, c->color.x, c->color.y, c->color.z);
+        }
+    }
+    s->num_static = s->count;
+
+    for(int i = 0; i < bodies.count; i ++) {
+        float x = bodies.prev_x[i] + (bodies.pos_x[i] - bodies.prev_x[i]) * interp_alpha;
+        float y = bodies.prev_y[i] + (bodies.pos_y[i] - bodies.prev_y[i]) * interp_alpha;
+        snapshotCircle(s, x, y, bodies.radius[i], bodies.color_r[i], bodies.color_g[i], bodies.color_b[i]);
+    }
+}
+
+// update physics variables
+int updateCircle(struct Bodies *b, int i, float dt) {
+
+    // add gravity and air resistance
+    if(b->mass[i] > 0) {
+        b->vel_y[i] += gravity * dt;
+    }
+
+    return moveCircle(b, i, dt);
+}
+
+int moveCircle(struct Bodies *b, int i, float dt) {
+    if(b->mass[i] > 0) {
+        b->pos_x[i] += b->vel_x[i] * dt;
+        b->pos_y[i] += b->vel_y[i] * dt;
+    }
+
+    if(b->color_g[i] < 1.0f) {
+        b->color_g[i] += dt / 4;
+    }
+    if(b->color_b[i] < 1.0f) {
+        b->color_b[i] += dt / 4;
+    }
+    if(b->color_g[i] > 1.0f) {
+        b->color_g[i] = 1.0f;
+    }
+    if(b->color_b[i] > 1.0f) {
+        b->color_b[i] = 1.0f;
+    }
+
+    // if offscreen, return 1
+    float r = b->radius[i];
+    if(b->pos_x[i] + r < 0 || b->pos_x[i] - r > SCREEN_WIDTH
+        || b->pos_y[i] + r < 0 || b->pos_y[i] - r > SCREEN_HEIGHT) {
+        return 1;
+    }
+
+    return 0;
+}
+
+// size the grid from the largest moving circle and fill it
+static void buildGrid() {
+    float max_radius = 0;
+
+    for(int i = 0; i < bodies.count; i ++) {
+        if(bodies.inv_mass[i] != 0 && bodies.radius[i] > max_radius) {
+            max_radius = bodies.radius[i];
+        }
+    }
+    if(max_radius == 0) {
+        max_radius = 16;
+    }
+
+    clearGrid(&grid, max_radius * 2, bodies.count);
+    for(int i = 0; i < bodies.count; i ++) {
+        insertGrid(&grid, i, bodies.pos_x[i], bodies.pos_y[i], bodies.radius[i]);
+        bodies.grid_x[i] = bodies.pos_x[i];
+        bodies.grid_y[i] = bodies.pos_y[i];
+    }
+    grid_moved = 0;
+}
+
+// call after body i moves during updatePhysics
+// grows grid_moved to cover it, grid queries are padded by it so bodies that
+// moved since the grid was built are still found
+// sweep and prune pairs are only complete while every body is inside its
+// proxy, so leaving it marks them stale and grows the margin
+static void noteMoved(int i) {
+    float x = bodies.pos_x[i];
+    float y = bodies.pos_y[i];
+    float r = bodies.radius[i];
+    float dx = fabsf(x - bodies.grid_x[i]);
+    float dy = fabsf(y - bodies.grid_y[i]);
+    if(dx > grid_moved) {
+        grid_moved = dx;
+    }
+    if(dy > grid_moved) {
+        grid_moved = dy;
+    }
+
+    if(broadphase == BROADPHASE_SAP && bodies.proxy[i] >= 0) {
+        struct SapProxy *p = &sap.proxies[bodies.proxy[i]];
+        float out[4] = {
+            p->min[0] - (x - r), x + r - p->max[0],
+            p->min[1] - (y - r), y + r - p->max[1]
+        };
+        for(int k = 0; k < 4; k ++) {
+            if(out[k] > 0) {
+                sap_stale = 1;
+                if(sap_margin + out[k] > sap_needed) {
+                    sap_needed = sap_margin + out[k];
+                }
+            }
+        }
+    }
+}
+
+// bring every proxy up to date, adding proxies for new bodies
+// a body's bounds reach as far as its velocity takes it by now, plus sap_margin
+static void syncSap(uint64_t now) {
+    if(sap_needed > sap_margin) {
+        sap_margin = sap_needed;
+    }
+    sap_needed = 0;
+
+    for(int i = 0; i < bodies.count; i ++) {
+        float dt = ticksToSeconds(now - bodies.last_update_time[i]);
+        float x = bodies.pos_x[i];
+        float y = bodies.pos_y[i];
+        float to_x = x + bodies.vel_x[i] * dt;
+        float to_y = y + bodies.vel_y[i] * dt;
+        float r = bodies.radius[i] + sap_margin;
+        float min_x = min(x, to_x) - r;
+        float min_y = min(y, to_y) - r;
+        float max_x = (x > to_x ? x : to_x) + r;
+        float max_y = (y > to_y ? y : to_y) + r;
+
+        if(bodies.proxy[i] < 0) {
+            int proxy = addSapProxy(&sap, min_x, min_y, max_x, max_y, 0);
+            if(proxy >= sap_body_capacity) {
+                sap_body_capacity = sap.proxies_capacity;
+                sap_body = realloc(sap_body, sap_body_capacity * sizeof(int));
+                if(sap_body == 0) {
+                    printf("error allocating memory for sap bodies\n");
+                    exit(1);
+                }
+            }
+            sap_body[proxy] = i;
+            bodies.proxy[i] = proxy;
+        }
+        else {
+            moveSapProxy(&sap, bodies.proxy[i], min_x, min_y, max_x, max_y);
+        }
+    }
+
+    updateSap(&sap);
+    sap_stale = 0;
+}
+
+// grows one of the pair batch buffers
+static void *growPairBuffer(void *arr, int *capacity, int needed, int elem_size) {
+    if(needed <= *capacity) {
+        return arr;
+    }
+    int c = *capacity == 0 ? 64 : *capacity;
+    while(c < needed) {
+        c *= 2;
+    }
+    arr = realloc(arr, c * elem_size);
+    if(arr == 0) {
+        printf("error allocating memory for pair batch\n");
+        exit(1);
+    }
+    *capacity = c;
+    return arr;
+}
+
+static void wakeBody(int i) {
+    // sleeping bodies gather no contacts, so the island it slept with is
+    // the only record of what else has to wake
+    if(bodies.sleep_island[i] >= 0) {
+        woken_islands = growPairBuffer(woken_islands, &woken_islands_capacity, num_woken_islands + 1, sizeof(int));
+        woken_islands[num_woken_islands ++] = bodies.sleep_island[i];
+        bodies.sleep_island[i] = -1;
+    }
+
+    bodies.sleeping[i] = 0;
+    bodies.sleep_time[i] = 0;
+    bodies.sleep_x[i] = bodies.pos_x[i];
+    bodies.sleep_y[i] = bodies.pos_y[i];
+    bodies.still_steps[i] = 0;
+    bodies.fx_sleep_x[i] = bodies.fx_pos_x[i];
+    bodies.fx_sleep_y[i] = bodies.fx_pos_y[i];
+}
+
+// makes room for at least n gathers, new ones start empty
+static void growGathers(int n) {
+    if(n <= gathers_capacity) {
+        return;
+    }
+    int c = gathers_capacity == 0 ? 4 : gathers_capacity;
+    while(c < n) {
+        c *= 2;
+    }
+    gathers = realloc(gathers, c * sizeof(struct Gather));
+    if(gathers == 0) {
+        printf("error allocating memory for gathers\n");
+        exit(1);
+    }
+    memset(gathers + gathers_capacity, 0, (c - gathers_capacity) * sizeof(struct Gather));
+    gathers_capacity = c;
+}
+
+static void clearGather(struct Gather *g) {
+    g->num_rect_pairs = 0;
+    g->num_found = 0;
+    g->pair_tests = 0;
+}
+
+// makes room for n more contacts and returns where they go
+static struct Manifold *reserveContacts(struct Gather *g, int n) {
+    g->found = growPairBuffer(g->found, &g->found_capacity, g->num_found + n, sizeof(struct Manifold));
+    g->found_static = growPairBuffer(g->found_static, &g->found_static_capacity, g->num_found + n, sizeof(char));
+    return g->found + g->num_found;
+}
+
+// keeps n contacts written at reserveContacts
+static void keepContacts(struct Gather *g, int n, int is_static) {
+    if(n == 0) {
+        return;
+    }
+    memset(g->found_static + g->num_found, is_static, n);
+    g->num_found += n;
+}
+
+// runs the artificial load and counts one pair test
+static void countPairTest(struct Gather *g) {
+    for(int i = 0; i < pair_work; i ++);
+    g->pair_tests ++;
+}
+
+// narrow phase for body i against a batch of other bodies
+static void gatherPairs(struct Gather *g, int i, const int *others, int n) {
+    g->pair_a = growPairBuffer(g->pair_a, &g->pair_a_capacity, n, sizeof(int));
+    g->pair_b = growPairBuffer(g->pair_b, &g->pair_b_capacity, n, sizeof(int));
+
+    int num_pairs = 0;
+    for(int k = 0; k < n; k ++) {
+        int o = others[k];
+        if(o == i) {
+            continue;
+        }
+        // both bodies would find the pair before either responds, so the
+        // first in gather_list tests it
+        if(gathering && gather_rank[o] >= 0 && gather_rank[o] < gather_rank[i]) {
+            continue;
+        }
+        countPairTest(g);
+        g->pair_a[num_pairs] = i;
+        g->pair_b[num_pairs] = o;
+        num_pairs ++;
+    }
+
+    struct Manifold *out = reserveContacts(g, num_pairs);
+    keepContacts(g, narrowCircCirc(&bodies, g->pair_a, g->pair_b, num_pairs, out), 0);
+}
+
+// broad and narrow phase for the moving bodies near body i
+// sweep and prune pairs must be synced first if they went stale
+static void gatherNeighbors(struct Gather *g, int i) {
+    if(broadphase == BROADPHASE_GRID) {
+        int n = queryGrid(&grid, bodies.pos_x[i], bodies.pos_y[i], bodies.radius[i] + grid_moved, &g->candidates, &g->candidates_capacity);
+        gatherPairs(g, i, g->candidates, n);
+    }
+    else if(broadphase == BROADPHASE_SAP) {
+        // persistent pairs, looked up from this body's side
+        int n;
+        int *neighbors = getSapNeighbors(&sap, bodies.proxy[i], &n);
+        g->candidates = growPairBuffer(g->candidates, &g->candidates_capacity, n, sizeof(int));
+        for(int k = 0; k < n; k ++) {
+            g->candidates[k] = sap_body[neighbors[k]];
+        }
+        gatherPairs(g, i, g->candidates, n);
+    }
+    else {
+        g->candidates = growPairBuffer(g->candidates, &g->candidates_capacity, bodies.count, sizeof(int));
+        for(int j = 0; j < bodies.count; j ++) {
+            g->candidates[j] = j;
+        }
+        gatherPairs(g, i, g->candidates, bodies.count);
+    }
+}
+
+// gatherNeighbors for the bodies that gather this pass
+static void gatherRanked(struct Gather *g, int i) {
+    if(gather_rank[i] >= 0) {
+        gatherNeighbors(g, i);
+    }
+}
+
+// narrow phase of body i against the static circles, or the whole field
+// rect pairs are only collected, collideStatics tests them grouped by rect
+static void gatherStatics(struct Gather *g, int i) {
+    // static against static never collides, and sleeping bodies rest where they are
+    if(bodies.inv_mass[i] == 0 || bodies.sleeping[i]) {
+        return;
+    }
+    // a body the schedule skips is left for the pass that steps it
+    if(lod_pass && lod_level[i] < 0) {
+        return;
+    }
+
+    float x = bodies.pos_x[i];
+    float y = bodies.pos_y[i];
+    float r = bodies.radius[i];
+
+    // one lookup in the baked field stands in for every static body
+    if(static_collision == STATIC_SDF) {
+        float d, gx, gy;
+        countPairTest(g);
+        if(sampleSdf(&static_sdf, x, y, &d, &gx, &gy) && d < r) {
+            struct Manifold *m = reserveContacts(g, 1);
+            float len = sqrt(gx * gx + gy * gy);
+            m->a = i;
+            m->b = -1;
+            m->penetration = r - d;
+            // gradient points away from the surface, normal points into it
+            if(len > 0.0001f) {
+                m->norm.x = -gx / len;
+                m->norm.y = -gy / len;
+            }
+            else {
+                m->norm.x = 1.0f;
+                m->norm.y = 0.0f;
+            }
+            keepContacts(g, 1, 1);
+        }
+        return;
+    }
+
+    int n = queryBvh(&static_bvh, x - r, y - r, x + r, y + r, &g->static_candidates, &g->static_candidates_capacity);
+
+    g->rect_pair_body = growPairBuffer(g->rect_pair_body, &g->rect_pair_body_capacity, g->num_rect_pairs + n, sizeof(int));
+    g->rect_pair_rect = growPairBuffer(g->rect_pair_rect, &g->rect_pair_rect_capacity, g->num_rect_pairs + n, sizeof(int));
+
+    for(int k = 0; k < n; k ++) {
+        int id = g->static_candidates[k];
+
+        countPairTest(g);
+
+        if(id & 1) {
+            g->rect_pair_body[g->num_rect_pairs] = i;
+            g->rect_pair_rect[g->num_rect_pairs] = id >> 1;
+            g->num_rect_pairs ++;
+            continue;
+        }
+
+        struct Manifold *m = reserveContacts(g, 1);
+        m->a = i;
+        m->b = id;
+        if(isCollidingCircVStatic(&bodies, m, &static_circles[id >> 1])) {
+            keepContacts(g, 1, 1);
+        }
+    }
+}
+
+// response to a contact between two moving bodies
+static void respondPair(struct Manifold *m) {
+    int i = m->a;
+    int j = m->b;
+
+    // touching a sleeping body wakes it, the island it slept with follows in updateSleep
+    if(bodies.sleeping[j]) {
+        wakeBody(j);
+    }
+    if(bodies.inv_mass[i] != 0 && bodies.inv_mass[j] != 0) {
+        joinIslands(&islands, i, j);
+    }
+
+    if(solving) {
+        addSolverContact(&solver, i, j, m->norm.x, m->norm.y, m->penetration, solverPairKey(bodies.id[i], bodies.id[j]));
+    }
+    else {
+        collideCirc(&bodies, m);
+        posCorCircVCirc(&bodies, m);
+        noteMoved(i);
+        noteMoved(j);
+    }
+}
+
+// response to a contact between a moving body and static geometry
+static void respondStatic(struct Manifold *m) {
+    // flash a static circle like a moving one would
+    if(m->b >= 0 && !(m->b & 1)) {
+        struct Circle *c = &static_circles[m->b >> 1];
+        float vel_norm = -(bodies.vel_x[m->a] * m->norm.x + bodies.vel_y[m->a] * m->norm.y);
+        if(vel_norm <= 0) {
+            c->color.y -= fabsf(vel_norm / DV);
+            c->color.z -= fabsf(vel_norm / DV);
+            if(c->color.y < 0) {
+                c->color.y = 0;
+            }
+            if(c->color.z < 0) {
+                c->color.z = 0;
+            }
+        }
+    }
+
+    if(solving) {
+        // the sdf stands in for all statics as static id -1
+        addSolverContact(&solver, m->a, -1, m->norm.x, m->norm.y, m->penetration, solverStaticKey(bodies.id[m->a], m->b));
+    }
+    else {
+        collideCircVRect(&bodies, m);
+        posCorCircVRect(&bodies, m);
+        noteMoved(m->a);
+    }
+}
+
+// responds to everything in g in the order it was found
+// always on the calling thread, response writes shared state
+static void respondGather(struct Gather *g) {
+    for(int k = 0; k < g->num_found; k ++) {
+        if(g->found_static[k]) {
+            respondStatic(&g->found[k]);
+        }
+        else {
+            respondPair(&g->found[k]);
+        }
+    }
+
+    stats.contacts += g->num_found;
+    stats.pair_tests += g->pair_tests;
+}
+
+// starts a job system of our own if nobody shared one,
+// or restarts ours if the thread count changed
+static void startJobs() {
+    if(jobs == &own_jobs && own_jobs.num_workers != phys_threads) {
+        destroyJobs(&own_jobs);
+        jobs = 0;
+    }
+    if(jobs == 0) {
+        initJobs(&own_jobs, phys_threads);
+        jobs = &own_jobs;
+    }
+}
+
+// runs func over count indices, split across phys_threads jobs if there is more than one
+static void runParallel(ParallelFunc func, void *arg, int count) {
+    if(phys_threads > 1) {
+        startJobs();
+        parallelFor(jobs, phys_threads, func, arg, count);
+        return;
+    }
+    for(int k = 0; k < count; k ++) {
+        func(arg, k);
+    }
+}
+
+// runs of bodies to gather, one run per parallelFor index
+struct GatherJob {
+    void (*gather)(struct Gather *g, int i);
+    const int *list;        // bodies in order, 0 for every body by index
+    int n;
+};
+
+static void gatherRun(void *arg, int index) {
+    struct GatherJob *job = arg;
+    struct Gather *g = &gathers[index];
+
+    clearGather(g);
+    int end = min((index + 1) * GATHER_BLOCK, job->n);
+    for(int k = index * GATHER_BLOCK; k < end; k ++) {
+        job->gather(g, job->list != 0 ? job->list[k] : k);
+    }
+}
+
+// gathers the first n bodies of list, GATHER_BLOCK bodies per run
+// the contacts are left in gathers[0] onwards for respondRuns
+static void gatherRuns(void (*gather)(struct Gather *g, int i), const int *list, int n) {
+    int num_runs = (n + GATHER_BLOCK - 1) / GATHER_BLOCK;
+    growGathers(num_runs);
+
+    struct GatherJob job = {gather, list, n};
+    runParallel(gatherRun, &job, num_runs);
+}
+
+// responds to the first n bodies gatherRuns filled, in list order
+static void respondRuns(int n) {
+    for(int k = 0; k * GATHER_BLOCK < n; k ++) {
+        respondGather(&gathers[k]);
+    }
+}
+
+// narrow phase of rect r against the bodies collideStatics grouped with it
+static void narrowRect(int r) {
+    int first = r == 0 ? 0 : rect_start[r - 1];
+    int n = rect_start[r] - first;
+    int num_contacts = narrowCircRect(&bodies, rect_bodies + first, n, static_rects, r, contacts + first);
+
+    for(int k = 0; k < num_contacts; k ++) {
+        contacts[first + k].b = r << 1 | 1;
+    }
+    rect_found[r] = num_contacts;
+}
+
+static void narrowRectJob(void *arg, int r) {
+    narrowRect(r);
+}
+
+static void respondRect(int r) {
+    int first = r == 0 ? 0 : rect_start[r - 1];
+    for(int k = 0; k < rect_found[r]; k ++) {
+        respondStatic(&contacts[first + k]);
+    }
+    stats.contacts += rect_found[r];
+}
+
+// narrow phase and response of every body against the static geometry
+// rect pairs are grouped by rect so the kernel gets 4 bodies per rect at a time
+static void collideStatics() {
+    int num_runs = (bodies.count + GATHER_BLOCK - 1) / GATHER_BLOCK;
+    gatherRuns(gatherStatics, 0, bodies.count);
+    respondRuns(bodies.count);
+
+    int num_pairs = 0;
+    for(int k = 0; k < num_runs; k ++) {
+        num_pairs += gathers[k].num_rect_pairs;
+    }
+    if(num_pairs == 0) {
+        return;
+    }
+
+    // counting sort by rect, in run order so each rect still sees its bodies in order
+    rect_start = growPairBuffer(rect_start, &rect_start_capacity, num_static_rects + 1, sizeof(int));
+    rect_bodies = growPairBuffer(rect_bodies, &rect_bodies_capacity, num_pairs, sizeof(int));
+    rect_found = growPairBuffer(rect_found, &rect_found_capacity, num_static_rects, sizeof(int));
+    contacts = growPairBuffer(contacts, &contacts_capacity, num_pairs, sizeof(struct Manifold));
+
+    memset(rect_start, 0, (num_static_rects + 1) * sizeof(int));
+    for(int k = 0; k < num_runs; k ++) {
+        struct Gather *g = &gathers[k];
+        for(int p = 0; p < g->num_rect_pairs; p ++) {
+            rect_start[g->rect_pair_rect[p] + 1] ++;
+        }
+    }
+    for(int r = 0; r < num_static_rects; r ++) {
+        rect_start[r + 1] += rect_start[r];
+    }
+    for(int k = 0; k < num_runs; k ++) {
+        struct Gather *g = &gathers[k];
+        for(int p = 0; p < g->num_rect_pairs; p ++) {
+            rect_bodies[rect_start[g->rect_pair_rect[p]] ++] = g->rect_pair_body[p];
+        }
+    }
+    // the scatter left each start at the end of its run, where the next rect's begins
+
+    if(phys_threads > 1) {
+        // every rect is tested before any response, each writes at its own offset
+        runParallel(narrowRectJob, 0, num_static_rects);
+        for(int r = 0; r < num_static_rects; r ++) {
+            respondRect(r);
+        }
+    }
+    else {
+        for(int r = 0; r < num_static_rects; r ++) {
+            narrowRect(r);
+            respondRect(r);
+        }
+    }
+}
+
+// static circles are never integrated, so fade their hit color here
+static void fadeStatics(uint64_t now) {
+    float dt = ticksToSeconds(now - last_static_update);
+    last_static_update = now;
+
+    for(int i = 0; i < num_static_circles; i ++) {
+        struct Circle *c = &static_circles[i];
+        c->color.y = c->color.y + dt / 4 > 1.0f ? 1.0f : c->color.y + dt / 4;
+        c->color.z = c->color.z + dt / 4 > 1.0f ? 1.0f : c->color.z + dt / 4;
+    }
+}
+
+static int compareDescending(const void *a, const void *b) {
+    return *(int *)b - *(int *)a;
+}
+
+static int compareAscending(const void *a, const void *b) {
+    return *(int *)a - *(int *)b;
+}
+
+// removes the bodies and their nodes
+// highest index first, so moving the last body never moves one still to be removed
+static void removeBodies(struct List *objects, int *list, int n) {
+    if(n == 0) {
+        return;
+    }
+    qsort(list, n, sizeof(int), compareDescending);
+
+    for(int k = 0; k < n; k ++) {
+        int i = list[k];
+        if(sap_initialized) {
+            removeSapProxy(&sap, bodies.proxy[i]);
+        }
+        if(bodies.node[i] == focus_node) {
+            focus_node = 0;
+        }
+        removeNode(objects, bodies.node[i]);
+        removeBody(&bodies, i);
+
+        if(i < bodies.count && bodies.proxy[i] >= 0) {
+            sap_body[bodies.proxy[i]] = i;
+        }
+    }
+}
+
+// gets the chosen broadphase ready for the current positions
+static void prepareBroadphase() {
+    if(broadphase == BROADPHASE_GRID) {
+        if(!grid_initialized) {
+            initGrid(&grid);
+            grid_initialized = 1;
+        }
+        buildGrid();
+    }
+    else if(broadphase == BROADPHASE_SAP) {
+        if(!sap_initialized) {
+            initSap(&sap);
+            sap_initialized = 1;
+        }
+        sap_margin = SAP_MARGIN + (sap_margin - SAP_MARGIN) * SAP_MARGIN_DECAY;
+        syncSap(step_end);
+    }
+}
+
+// narrow phase and response against the bodies near body i
+static void collideBody(int i) {
+    if(broadphase == BROADPHASE_SAP && sap_stale) {
+        syncSap(step_end);
+    }
+
+    growGathers(1);
+    clearGather(&gathers[0]);
+    gatherNeighbors(&gathers[0], i);
+    respondGather(&gathers[0]);
+}
+
+static void updateSleepTimer(int i, float dt) {
+    // resting contacts bounce, so judge stillness by drift from an anchor
+    // rather than by instantaneous velocity
+    float dx = bodies.pos_x[i] - bodies.sleep_x[i];
+    float dy = bodies.pos_y[i] - bodies.sleep_y[i];
+    if(dx * dx + dy * dy < SLEEP_DISTANCE * SLEEP_DISTANCE) {
+        bodies.sleep_time[i] += dt;
+    }
+    else {
+        bodies.sleep_x[i] = bodies.pos_x[i];
+        bodies.sleep_y[i] = bodies.pos_y[i];
+        bodies.sleep_time[i] = 0;
+    }
+}
+
+// moves body i by dt, returns 1 if it left the screen
+static int integrateBody(int i, float dt) {
+    stats.bodies_updated ++;
+    if(updateCircle(&bodies, i, dt)) {
+        return 1;
+    }
+    bodies.last_update_time[i] = step_end;
+    noteMoved(i);
+    updateSleepTimer(i, dt);
+
+    return 0;
+}
+
+// collides body i with the bodies near it and moves it by dt
+// returns 1 if it left the screen
+static int stepBody(int i, float dt) {
+    collideBody(i);
+    return integrateBody(i, dt);
+}
+
+// how long body i has been still, deterministic steps count whole steps
+// so no float sums go into the decision, small counts convert exactly
+static float stillTime(int i) {
+    return step_mode == STEP_DETERMINISTIC ? bodies.still_steps[i] : bodies.sleep_time[i];
+}
+
+// an island sleeps once every body in it has been still for SLEEP_TIME
+// anything still joined to a moving body by this pass's contacts wakes up,
+// and so does every body that fell asleep with one woken this pass
+static void updateSleep() {
+    float needed = step_mode == STEP_DETERMINISTIC ? SLEEP_STEPS : SLEEP_TIME;
+    island_still = growPairBuffer(island_still, &island_still_capacity, bodies.count, sizeof(float));
+
+    if(num_woken_islands > 0) {
+        qsort(woken_islands, num_woken_islands, sizeof(int), compareAscending);
+        for(int i = 0; i < bodies.count; i ++) {
+            if(bodies.sleeping[i] && bsearch(&bodies.sleep_island[i], woken_islands,
+                    num_woken_islands, sizeof(int), compareAscending) != 0) {
+                bodies.sleep_island[i] = -1;
+                wakeBody(i);
+            }
+        }
+        num_woken_islands = 0;
+    }
+
+    for(int i = 0; i < bodies.count; i ++) {
+        island_still[i] = needed;
+    }
+    for(int i = 0; i < bodies.count; i ++) {
+        if(bodies.inv_mass[i] == 0) {
+            continue;
+        }
+        int root = findIsland(&islands, i);
+        island_still[root] = min(island_still[root], stillTime(i));
+    }
+
+    for(int i = 0; i < bodies.count; i ++) {
+        if(bodies.inv_mass[i] == 0) {
+            continue;
+        }
+        int root = findIsland(&islands, i);
+        if(island_still[root] >= needed) {
+            if(!bodies.sleeping[i]) {
+                // named after its root's id, which unlike the index stays put
+                bodies.sleeping[i] = 1;
+                bodies.sleep_island[i] = bodies.id[root];
+                bodies.vel_x[i] = 0;
+                bodies.vel_y[i] = 0;
+                bodies.fx_vel_x[i] = 0;
+                bodies.fx_vel_y[i] = 0;
+            }
+            stats.sleeping ++;
+        }
+        else if(bodies.sleeping[i]) {
+            wakeBody(i);
+        }
+    }
+}
+
+// bodies are removed after a pass so broadphase indices stay valid
+static void queueRemoval(int i, int *num_removed) {
+    if(*num_removed >= removed_capacity) {
+        removed_capacity = removed_capacity == 0 ? 64 : removed_capacity * 2;
+        removed = realloc(removed, removed_capacity * sizeof(int));
+        if(removed == 0) {
+            printf("error allocating memory for removed bodies\n");
+            exit(1);
+        }
+    }
+    removed[(*num_removed) ++] = i;
+}
+
+// ranks the bodies in list by position, sleeping ones and the rest get -1
+static void rankGatherList(int n) {
+    gather_rank = growPairBuffer(gather_rank, &gather_rank_capacity, bodies.count, sizeof(int));
+    for(int i = 0; i < bodies.count; i ++) {
+        gather_rank[i] = -1;
+    }
+    for(int k = 0; k < n; k ++) {
+        if(!bodies.sleeping[gather_list[k]]) {
+            gather_rank[gather_list[k]] = k;
+        }
+    }
+}
+
+// steps the first n bodies of gather_list a batch at a time, each batch's
+// contacts gathered across the jobs, then responded to in list order, dt 0
+// steps each body by its own time since its last update
+// every contact in a batch is found before any is resolved, so unlike
+// stepBody a body never sees the response to contacts earlier in its batch
+// runtime is negative for no limit, returns how many bodies were stepped within it
+static int stepParallel(int n, uint64_t start, float runtime, float dt, int *num_removed) {
+    rankGatherList(n);
+    startBudget(&visit_budget, start, runtime);
+
+    int processed = 0;
+    int batch = 0;
+    while(processed < n && (batch = nextBatch(&visit_budget, batch)) > 0) {
+        batch = min(batch, n - processed);
+        const int *list = gather_list + processed;
+
+        // earlier batches may have moved or woken some of these
+        if(broadphase == BROADPHASE_SAP && sap_stale) {
+            syncSap(step_end);
+        }
+        for(int k = 0; k < batch; k ++) {
+            if(gather_rank[list[k]] < 0 && !bodies.sleeping[list[k]]) {
+                gather_rank[list[k]] = processed + k;
+            }
+        }
+
+        gathering = 1;
+        gatherRuns(gatherRanked, list, batch);
+        gathering = 0;
+        respondRuns(batch);
+
+        for(int k = 0; k < batch; k ++) {
+            int i = list[k];
+
+            if(gather_rank[i] < 0) {
+                // keep the clock current so waking up is not one huge step
+                bodies.last_update_time[i] = step_end;
+            }
+            else if(integrateBody(i, dt > 0 ? dt : ticksToSeconds(step_end - bodies.last_update_time[i]))) {
+                queueRemoval(i, num_removed);
+            }
+        }
+        processed += batch;
+    }
+
+    return processed;
+}
+
+// one fixed step, each contact is resolved as soon as it is found
+static void immediateStep(struct List *objects) {
+    int num_removed = 0;
+
+    collideStatics();
+
+    if(phys_threads > 1) {
+        gather_list = growPairBuffer(gather_list, &gather_list_capacity, bodies.count, sizeof(int));
+        for(int i = 0; i < bodies.count; i ++) {
+            gather_list[i] = i;
+        }
+        stepParallel(bodies.count, 0, -1, FIXED_DT, &num_removed);
+    }
+    else {
+        for(int i = 0; i < bodies.count; i ++) {
+            if(bodies.sleeping[i]) {
+                continue;
+            }
+            if(stepBody(i, FIXED_DT)) {
+                queueRemoval(i, &num_removed);
+            }
+        }
+    }
 
-// must be called before any circles are added
-int initPhysRenderer(struct TexMan *texman, struct Shader *shdr) {
+    updateSleep();
+    removeBodies(objects, removed, num_removed);
+}
 
-    // set shader
-    shader = shdr;
+// one fixed step, every contact is gathered first and solved together
+static void solveStep(struct List *objects) {
+    int num_removed = 0;
 
-    // get texture id
-    circle_tex_id = getTextureId(texman, "circle");
-    rect_tex_id = getTextureId(texman, "rect");
+    // bodies woken while gathering join in from the next step
+    gather_list = growPairBuffer(gather_list, &gather_list_capacity, bodies.count, sizeof(int));
+    int n = 0;
+    for(int i = 0; i < bodies.count; i ++) {
+        if(bodies.sleeping[i]) {
+            continue;
+        }
+        gather_list[n ++] = i;
+        if(bodies.mass[i] > 0) {
+            bodies.vel_y[i] += gravity * FIXED_DT;
+        }
+    }
+    rankGatherList(n);
+
+    // nothing moves until the solver runs, so the contacts come out the
+    // same for any number of threads
+    clearSolver(&solver);
+    solving = 1;
+    collideStatics();
+    gathering = 1;
+    gatherRuns(gatherRanked, gather_list, n);
+    respondRuns(n);
+    gathering = 0;
+    solving = 0;
+
+    if(solver_mode == SOLVER_PARALLEL) {
+        startJobs();
+        solveVelocitiesColored(&solver, &bodies, solver_iterations, jobs, phys_threads);
+    }
+    else {
+        solveVelocities(&solver, &bodies, solver_iterations);
+    }
 
-    // intialize sprite renderer
-    initSpriteRenderer(&sprite);
+    for(int i = 0; i < bodies.count; i ++) {
+        if(bodies.sleeping[i]) {
+            continue;
+        }
+        stats.bodies_updated ++;
+        if(moveCircle(&bodies, i, FIXED_DT)) {
+            queueRemoval(i, &num_removed);
+        }
+        else {
+            bodies.last_update_time[i] = step_end;
+        }
+    }
 
-    renderer_initialized = 1;
-    return 0;
-}
+    if(solver_mode == SOLVER_PARALLEL) {
+        solvePositionsColored(&solver, &bodies, jobs, phys_threads);
+    }
+    else {
+        solvePositions(&solver, &bodies);
+    }
 
-// initialize this game object
-struct Node *addCircle(struct List *objects, float x, float y, float xv, float yv, float radius, float mass) {
-    if(renderer_initialized == 0) {
-        return 0;
+    for(int i = 0; i < bodies.count; i ++) {
+        if(!bodies.sleeping[i]) {
+            updateSleepTimer(i, FIXED_DT);
+        }
     }
 
-    struct Circle c;
-    struct Node *new;
+    updateSleep();
+    removeBodies(objects, removed, num_removed);
+}
 
-    c.pos.x = x;
-    c.pos.y = y;
-    c.vel.x = xv;
-    c.vel.y = yv;
-    c.explosive = 0;
+// a contact worked out in fixed point for STEP_DETERMINISTIC, a is always a moving body
+struct FixedManifold {
+    int a;
+    int b;
+    fixed penetration;
+    fixed norm_x;
+    fixed norm_y;
+};
+
+static fixed fxInvMass(int i) {
+    return bodies.mass[i] == 0 ? 0 : fxDiv(FX_ONE, toFixed(bodies.mass[i]));
+}
 
-    c.radius = radius;
-    c.color.x = 1.0f;
-    c.color.y = 1.0f;
-    c.color.z = 1.0f;
+// circleContact in fixed point
+// differs from it in rounding only: the distance is the integer square root
+// rounded down and the normal is truncated, so the penetration can come out
+// a unit deeper. Coincident centres get penetration ar and a +x normal there too
+static int fxCircleContact(fixed ax, fixed ay, fixed ar, fixed bx, fixed by, fixed br, struct FixedManifold *m) {
+    fixed nx = bx - ax;
+    fixed ny = by - ay;
+    fixed r = ar + br;
+
+    int64_t d2 = fxLengthSquared(nx, ny);
+    if(d2 > (int64_t)r * r) {
+        return 0;
+    }
 
-    c.mass = mass;
-    if(c.mass == 0) {
-        c.inv_mass = 0;
+    fixed d = fxSqrt64(d2);
+    if(d != 0) {
+        m->penetration = r - d;
+        m->norm_x = fxDiv(nx, d);
+        m->norm_y = fxDiv(ny, d);
     }
     else {
-        c.inv_mass = 1 / c.mass;
+        m->penetration = ar;
+        m->norm_x = FX_ONE;
+        m->norm_y = 0;
+    }
+    return 1;
+}
+
+// isCollidingCircVRect in fixed point
+// differs from it when the center is on the rect's edge: the distance there
+// is 0, which this takes as one unit and isCollidingCircVRect as 0.0001, so
+// the two normals scale differently. There are no NaNs to catch in integers
+static int fxCircleRect(int a, struct Rect *r, struct FixedManifold *m) {
+    fixed px = bodies.fx_pos_x[a];
+    fixed py = bodies.fx_pos_y[a];
+    fixed radius = toFixed(bodies.radius[a]);
+    fixed rx = toFixed(r->pos.x);
+    fixed ry = toFixed(r->pos.y);
+    fixed rl = toFixed(r->length);
+    fixed rh = toFixed(r->height);
+
+    // closest point of the rect to the center
+    fixed cx = px < rx ? rx : (px > rx + rl ? rx + rl : px);
+    fixed cy = py < ry ? ry : (py > ry + rh ? ry + rh : py);
+
+    // center inside, push out through the nearest edge
+    int inside = px == cx && py == cy;
+    if(inside) {
+        fixed dtl = px - rx;
+        fixed dtr = rl - dtl;
+        fixed dtt = py - ry;
+        fixed dtb = rh - dtt;
+        if(dtl < dtr && dtl < dtt && dtl < dtb) {
+            cx = rx;
+        }
+        else if(dtr < dtt && dtr < dtb) {
+            cx = rx + rl;
+        }
+        else if(dtt < dtb) {
+            cy = ry;
+        }
+        else {
+            cy = ry + rh;
+        }
     }
-    c.restitution = 0.7;
 
-    c.last_update_time = glfwGetTime();
+    fixed nx = cx - px;
+    fixed ny = cy - py;
+    int64_t d2 = fxLengthSquared(nx, ny);
+    if(!inside && d2 > (int64_t)radius * radius) {
+        return 0;
+    }
 
-    new = insertNode(objects, &c, sizeof(struct Circle), CIRC_TYPE);
+    fixed d = fxSqrt64(d2);
+    if(d == 0) {
+        d = 1;
+    }
+    m->norm_x = inside ? -fxDiv(nx, d) : fxDiv(nx, d);
+    m->norm_y = inside ? -fxDiv(ny, d) : fxDiv(ny, d);
+    m->penetration = radius - d;
+    return 1;
+}
 
-    return new;
+// the same darkening as collideCirc, colors are only drawn so floats are fine
+static void fxFlash(float *g, float *b, fixed vel_norm) {
+    float dv = fabsf(fixedToFloat(vel_norm) / DV);
+    *g = *g - dv < 0 ? 0 : *g - dv;
+    *b = *b - dv < 0 ? 0 : *b - dv;
 }
 
-// initialize this game object
-int addRect(struct List *objects, float x, float y, float l, float h) {
-    if(renderer_initialized == 0) {
-        return 1;
+// noteMoved for the fixed position, grid queries are padded by grid_moved
+static void fxNoteMoved(int i) {
+    float dx = fabsf(fixedToFloat(bodies.fx_pos_x[i]) - bodies.grid_x[i]);
+    float dy = fabsf(fixedToFloat(bodies.fx_pos_y[i]) - bodies.grid_y[i]);
+    if(dx > grid_moved) {
+        grid_moved = dx;
+    }
+    if(dy > grid_moved) {
+        grid_moved = dy;
+    }
+}
+
+// respondPair with collideCirc and posCorCircVCirc, in fixed point
+// differs from posCorCircVCirc, which takes max(penetration - slop, 0) through
+// the max macro above. That macro gives 1 or 0, so every pair deeper than the
+// slop is moved the same distance. This moves it by 80% of its depth past FX_SLOP
+static void fxRespondPair(struct FixedManifold *m) {
+    int a = m->a;
+    int o = m->b;
+    fixed ima = fxInvMass(a);
+    fixed imo = fxInvMass(o);
+    if(ima == 0 && imo == 0) {
+        return;
     }
 
-    struct Rect r;
+    if(bodies.sleeping[o]) {
+        wakeBody(o);
+    }
+    if(ima != 0 && imo != 0) {
+        joinIslands(&islands, a, o);
+    }
 
-    r.pos.x = x;
-    r.pos.y = y;
-    r.length = l;
-    r.height = h;
-    r.color.x = 1.0f;
-    r.color.y = 1.0f;
-    r.color.z = 1.0f;
-    r.restitution = 1;
+    fixed rvx = bodies.fx_vel_x[o] - bodies.fx_vel_x[a];
+    fixed rvy = bodies.fx_vel_y[o] - bodies.fx_vel_y[a];
+    fixed vel_norm = fxMul(rvx, m->norm_x) + fxMul(rvy, m->norm_y);
+    if(bodies.explosive[a] || bodies.explosive[o]) {
+        vel_norm -= toFixed(EXPLOSIVE_SPEED);
+    }
 
-    insertNode(objects, &r, sizeof(struct Rect), RECT_TYPE);
+    // only closing contacts get an impulse
+    if(vel_norm <= 0) {
+        fxFlash(&bodies.color_g[a], &bodies.color_b[a], vel_norm);
+        fxFlash(&bodies.color_g[o], &bodies.color_b[o], vel_norm);
+
+        fixed e = min(toFixed(bodies.restitution[a]), toFixed(bodies.restitution[o]));
+        fixed j = fxDiv(fxMul(-(FX_ONE + e), vel_norm), ima + imo);
+        fixed ix = fxMul(j, m->norm_x);
+        fixed iy = fxMul(j, m->norm_y);
+        bodies.fx_vel_x[a] -= fxMul(ima, ix);
+        bodies.fx_vel_y[a] -= fxMul(ima, iy);
+        bodies.fx_vel_x[o] += fxMul(imo, ix);
+        bodies.fx_vel_y[o] += fxMul(imo, iy);
+    }
 
-    return 0;
+    if(m->penetration > FX_SLOP) {
+        fixed c = fxMul(fxDiv(m->penetration - FX_SLOP, ima + imo), FX_PERCENT);
+        fixed cx = fxMul(c, m->norm_x);
+        fixed cy = fxMul(c, m->norm_y);
+        bodies.fx_pos_x[a] -= fxMul(ima, cx);
+        bodies.fx_pos_y[a] -= fxMul(ima, cy);
+        bodies.fx_pos_x[o] += fxMul(imo, cx);
+        bodies.fx_pos_y[o] += fxMul(imo, cy);
+        fxNoteMoved(a);
+        fxNoteMoved(o);
+    }
 }
 
-int drawObjects(struct List *objects, float runtime) {
-    struct Node *start_node;
-    float start_time = glfwGetTime();
+// collideCircVRect and posCorCircVRect in fixed point, static_circle for the flash
+// differs from posCorCircVRect the same way fxRespondPair does from posCorCircVCirc
+static void fxRespondStatic(struct FixedManifold *m, struct Circle *static_circle) {
+    int a = m->a;
 
-    if(render_node == 0) {
-        render_node = objects->front;
+    fixed vel_norm = -(fxMul(bodies.fx_vel_x[a], m->norm_x) + fxMul(bodies.fx_vel_y[a], m->norm_y));
+    if(vel_norm <= 0) {
+        fxFlash(&bodies.color_g[a], &bodies.color_b[a], vel_norm);
+        if(static_circle != 0) {
+            fxFlash(&static_circle->color.y, &static_circle->color.z, vel_norm);
+        }
+
+        // the inverse mass cancels out against a static body
+        fixed e = min(toFixed(bodies.restitution[a]), FX_ONE);
+        fixed j = fxMul(-(FX_ONE + e), vel_norm);
+        bodies.fx_vel_x[a] -= fxMul(j, m->norm_x);
+        bodies.fx_vel_y[a] -= fxMul(j, m->norm_y);
+    }
+
+    if(m->penetration > FX_SLOP) {
+        fixed c = fxMul(m->penetration - FX_SLOP, FX_PERCENT);
+        bodies.fx_pos_x[a] -= fxMul(c, m->norm_x);
+        bodies.fx_pos_y[a] -= fxMul(c, m->norm_y);
+        fxNoteMoved(a);
     }
-    start_node = render_node->prev;
+}
+
+// Contacts for body i, each resolved as soon as it is found.
+// The float broadphase only suggests candidates. The grid has every body where
+// the step started, so grid queries are padded by the furthest any body has
+// moved since, plus a pixel for float rounding, and no real contact is missed.
+// Candidates are sorted so the order they come back in can't matter.
+static void fxCollideBody(int i) {
+    struct Gather *g = &gathers[0];
+    float x = fixedToFloat(bodies.fx_pos_x[i]);
+    float y = fixedToFloat(bodies.fx_pos_y[i]);
+    float r = bodies.radius[i] + 1;
+    fixed radius = toFixed(bodies.radius[i]);
+
+    int n = queryGrid(&grid, x, y, r + grid_moved, &g->candidates, &g->candidates_capacity);
+    if(n > 1) {
+        qsort(g->candidates, n, sizeof(int), compareAscending);
+    }
+    for(int k = 0; k < n; k ++) {
+        int j = g->candidates[k];
+        // an oversize body can come back twice
+        if(j == i || (k > 0 && j == g->candidates[k - 1])) {
+            continue;
+        }
+        countPairTest(g);
 
-    while(render_node != start_node && glfwGetTime() - start_time < runtime) {
-        if(render_node->data_type == CIRC_TYPE) {
-            drawCircle((struct Circle *)render_node->data);
+        struct FixedManifold m = {.a = i, .b = j};
+        if(fxCircleContact(bodies.fx_pos_x[i], bodies.fx_pos_y[i], radius,
+            bodies.fx_pos_x[j], bodies.fx_pos_y[j], toFixed(bodies.radius[j]), &m)) {
+            stats.contacts ++;
+            fxRespondPair(&m);
         }
-        else if(render_node->data_type == RECT_TYPE) {
-            drawRect((struct Rect *)render_node->data);
+    }
+
+    // static against static never collides
+    if(bodies.mass[i] == 0) {
+        return;
+    }
+
+    // statics never move, so their query needs no padding past the pixel
+    n = queryBvh(&static_bvh, x - r, y - r, x + r, y + r, &g->static_candidates, &g->static_candidates_capacity);
+    if(n > 1) {
+        qsort(g->static_candidates, n, sizeof(int), compareAscending);
+    }
+    for(int k = 0; k < n; k ++) {
+        int id = g->static_candidates[k];
+        countPairTest(g);
+
+        struct FixedManifold m = {.a = i, .b = id};
+        struct Circle *c = 0;
+        int hit;
+        if(id & 1) {
+            hit = fxCircleRect(i, &static_rects[id >> 1], &m);
         }
         else {
-            printf("DRAW OBJECTS ERROR: Unkown type given: %d\n", render_node->data_type);
-            exit(1);
+            c = &static_circles[id >> 1];
+            hit = fxCircleContact(bodies.fx_pos_x[i], bodies.fx_pos_y[i], radius,
+                toFixed(c->pos.x), toFixed(c->pos.y), toFixed(c->radius), &m);
         }
+        if(hit) {
+            stats.contacts ++;
+            fxRespondStatic(&m, c);
+        }
+    }
+}
+
+// updateCircle and updateSleepTimer in fixed point, returns 1 if body i left the screen
+static int fxIntegrateBody(int i) {
+    stats.bodies_updated ++;
+
+    if(bodies.mass[i] > 0) {
+        bodies.fx_vel_y[i] += fxMul(toFixed(gravity), FX_DT);
+        bodies.fx_pos_x[i] += fxMul(bodies.fx_vel_x[i], FX_DT);
+        bodies.fx_pos_y[i] += fxMul(bodies.fx_vel_y[i], FX_DT);
+    }
+
+    bodies.color_g[i] = min(bodies.color_g[i] + FIXED_DT / 4, 1.0f);
+    bodies.color_b[i] = min(bodies.color_b[i] + FIXED_DT / 4, 1.0f);
+
+    fixed dx = bodies.fx_pos_x[i] - bodies.fx_sleep_x[i];
+    fixed dy = bodies.fx_pos_y[i] - bodies.fx_sleep_y[i];
+    if(fxLengthSquared(dx, dy) < (int64_t)toFixed(SLEEP_DISTANCE) * toFixed(SLEEP_DISTANCE)) {
+        bodies.still_steps[i] ++;
+    }
+    else {
+        bodies.fx_sleep_x[i] = bodies.fx_pos_x[i];
+        bodies.fx_sleep_y[i] = bodies.fx_pos_y[i];
+        bodies.still_steps[i] = 0;
+    }
+
+    fixed r = toFixed(bodies.radius[i]);
+    return bodies.fx_pos_x[i] + r < 0 || bodies.fx_pos_x[i] - r > toFixed(SCREEN_WIDTH)
+        || bodies.fx_pos_y[i] + r < 0 || bodies.fx_pos_y[i] - r > toFixed(SCREEN_HEIGHT);
+}
+
+// copies the fixed state into the floats everything else reads
+static void mirrorFixed() {
+    for(int i = 0; i < bodies.count; i ++) {
+        bodies.pos_x[i] = fixedToFloat(bodies.fx_pos_x[i]);
+        bodies.pos_y[i] = fixedToFloat(bodies.fx_pos_y[i]);
+        bodies.vel_x[i] = fixedToFloat(bodies.fx_vel_x[i]);
+        bodies.vel_y[i] = fixedToFloat(bodies.fx_vel_y[i]);
+    }
+}
+
+// one fixed step like immediateStep, in fixed point and always on this thread
+// candidates always come from the grid, whatever the broadphase
+static void deterministicStep(struct List *objects) {
+    int num_removed = 0;
+
+    if(!grid_initialized) {
+        initGrid(&grid);
+        grid_initialized = 1;
+    }
+    buildGrid();
+    growGathers(1);
+    clearGather(&gathers[0]);
 
-        render_node = render_node->next;
-        if(render_node == 0) {
-            render_node = objects->front;
+    for(int i = 0; i < bodies.count; i ++) {
+        if(bodies.sleeping[i]) {
+            continue;
         }
-        if(start_node == 0) {
-            start_node = objects->front;
+        fxCollideBody(i);
+        if(fxIntegrateBody(i)) {
+            queueRemoval(i, &num_removed);
+            continue;
         }
+        bodies.last_update_time[i] = step_end;
+        fxNoteMoved(i);
     }
+    stats.pair_tests += gathers[0].pair_tests;
 
-    return 0;
+    updateSleep();
+    removeBodies(objects, removed, num_removed);
+    mirrorFixed();
 }
 
-// draw this object to the screen
-int drawCircle(struct Circle *c) {
-    drawSprite(&sprite, shader, circle_tex_id, 
-    (vec2){c->pos.x - c->radius, c->pos.y - c->radius},     // position
-    (vec2){c->radius * 2, c->radius * 2},                   // length, width
-    0.0f, (vec3){c->color.x, c->color.y, c->color.z});
+// one FIXED_DT step of every body
+static void fixedStep(struct List *objects) {
+    // input for a deterministic step belongs to its tick, not to a frame
+    if(step_mode == STEP_DETERMINISTIC && tick_func != 0) {
+        tick_func(objects, phys_tick, tick_arg);
+    }
 
-    return 0;
-}
+    memcpy(bodies.prev_x, bodies.pos_x, bodies.count * sizeof(float));
+    memcpy(bodies.prev_y, bodies.pos_y, bodies.count * sizeof(float));
 
-int drawRect(struct Rect *r) {
-    drawSprite(&sprite, shader, rect_tex_id, 
-    (vec2){r->pos.x, r->pos.y},     // position
-    (vec2){r->length, r->height},                   // length, width
-    0.0f, (vec3){r->color.x, r->color.y, r->color.z});
+    step_end += secondsToTicks(FIXED_DT);
+    clearIslands(&islands, bodies.count);
+    stats.sleeping = 0;
 
-    return 0;
+    if(step_mode == STEP_DETERMINISTIC) {
+        deterministicStep(objects);
+        phys_tick ++;
+        return;
+    }
+
+    prepareBroadphase();
+    if(solver_mode == SOLVER_SEQUENTIAL || solver_mode == SOLVER_PARALLEL) {
+        solveStep(objects);
+    }
+    else {
+        immediateStep(objects);
+    }
 }
 
-// update physics variables
-int updateCircle(struct Circle *c, float dt) {
+// every body takes whole FIXED_DT steps, runtime only limits the substeps
+static void updateFixed(struct List *objects, float runtime, uint64_t now) {
+    if(last_step_time == UINT64_MAX) {
+        last_step_time = now;
+    }
+    accumulator += ticksToSeconds(now - last_step_time);
+    last_step_time = now;
 
-    // add gravity and air resistance
-    if(c->mass > 0) {
-        c->vel.y += gravity * dt;
+    // drop time we could never catch up on instead of spiralling
+    if(accumulator > MAX_SUBSTEPS * FIXED_DT) {
+        accumulator = MAX_SUBSTEPS * FIXED_DT;
+    }
+    step_end = now - secondsToTicks(accumulator);
 
-        c->pos.x += c->vel.x * dt;
-        c->pos.y += c->vel.y * dt;
+    int steps = 0;
+    while(accumulator >= FIXED_DT && steps < MAX_SUBSTEPS) {
+        // the first step always runs, so a tight budget still makes progress
+        if(steps > 0 && getTicks() - now >= secondsToTicks(runtime)) {
+            break;
+        }
+        fixedStep(objects);
+        accumulator -= FIXED_DT;
+        steps ++;
     }
 
-    if(c->color.y < 1.0f) {
-        c->color.y += dt / 4;
+    interp_alpha = accumulator / FIXED_DT;
+    if(interp_alpha > 1.0f) {
+        interp_alpha = 1.0f;
     }
-    if(c->color.z < 1.0f) {
-        c->color.z += dt / 4;
+}
+
+// how often body i is visited, level l is visited every 2^l passes
+// by distance to the nearest focus, full rate when there is none
+static int lodLevel(int i) {
+    float fx[2], fy[2];
+    int n = 0;
+    if(focus_node != 0) {
+        int f = bodyIndex(focus_node);
+        fx[n] = bodies.pos_x[f];
+        fy[n] = bodies.pos_y[f];
+        n ++;
     }
-    if(c->color.y > 1.0f) {
-        c->color.y = 1.0f;
+    if(focus_point_set) {
+        fx[n] = focus_x;
+        fy[n] = focus_y;
+        n ++;
     }
-    if(c->color.z > 1.0f) {
-        c->color.z = 1.0f;
+    if(n == 0) {
+        return 0;
     }
 
-    // if offscreen, return 1
-    if(c->pos.x + c->radius < 0 || c->pos.x - c->radius > SCREEN_WIDTH
-        || c->pos.y + c->radius < 0 || c->pos.y - c->radius > SCREEN_HEIGHT) {
-        return 1;
+    float d2 = distSquared(bodies.pos_x[i], bodies.pos_y[i], fx[0], fy[0]);
+    if(n > 1) {
+        d2 = min(d2, distSquared(bodies.pos_x[i], bodies.pos_y[i], fx[1], fy[1]));
     }
 
-    return 0;
+    // each level reaches twice as far as the one before
+    int level = 0;
+    float reach = LOD_NEAR;
+    while(level < LOD_LEVELS - 1 && d2 > reach * reach) {
+        level ++;
+        reach *= 2;
+    }
+    return level;
 }
 
-// updates physics of all these objects
-int updatePhysics(struct List *objects, float runtime) {
-    struct Node *start_node, *other;
-    float start_time = glfwGetTime();
-
-    if(phys_node == 0) {
-        phys_node = objects->front;
-    }
-    start_node = phys_node->prev;
-
-    while(phys_node != start_node && glfwGetTime() - start_time < runtime) {
-        other = objects->front;
-        while(other != 0) {
-            if(other != phys_node) {
-                for(int i = 0; i < 2000; i ++);
-                if(phys_node->data_type == CIRC_TYPE && other->data_type == CIRC_TYPE) {
-                    struct Manifold m;
-                    m.a = phys_node->data;
-                    m.b = other->data;
-                    if(isCollidingCircVCirc(&m)){
-                        collideCirc(&m);
-                        posCorCircVCirc(&m);
-                    }
-                }
-                if(phys_node->data_type == CIRC_TYPE && other->data_type == RECT_TYPE) {
-                    struct Manifold m;
-                    m.a = phys_node->data;
-                    m.b = other->data;
-                    if(isCollidingCircVRect(&m)) {
-                        collideCircVRect(&m);
-                        posCorCircVRect(&m);
-                    }
-                }
+// picks the bodies this pass visits and returns how many
+// scheduledBody gives them in the order they are visited
+static int scheduleBodies(uint64_t now) {
+    gather_list = growPairBuffer(gather_list, &gather_list_capacity, bodies.count, sizeof(int));
+    if(phys_index >= bodies.count) {
+        phys_index = 0;
+    }
+
+    // round robin over the bodies, picking up where the last pass stopped
+    if(schedule == SCHEDULE_ROUND_ROBIN) {
+        for(int k = 0; k < bodies.count; k ++) {
+            gather_list[k] = (phys_index + k) % bodies.count;
+        }
+        num_scheduled = bodies.count;
+        return bodies.count;
+    }
+
+    // longest waiting first, filled in by scheduledBody
+    if(schedule == SCHEDULE_STALEST) {
+        clearHeap(&stale_heap);
+        for(int i = 0; i < bodies.count; i ++) {
+            float priority = ticksToSeconds(now - bodies.last_update_time[i]);
+            if(stale_speed_weight != 0) {
+                float speed = sqrtf(bodies.vel_x[i] * bodies.vel_x[i] + bodies.vel_y[i] * bodies.vel_y[i]);
+                priority *= 1 + stale_speed_weight * speed;
             }
-            other = other->next;
-        }
-        if(phys_node->data_type == CIRC_TYPE) {
-            float dt = glfwGetTime() - ((struct Circle *)phys_node->data)->last_update_time;
-            if(updateCircle((struct Circle *)phys_node->data, dt)) {
-                struct Node *temp = phys_node;
-
-                // update render_node if it is being removed
-                if(phys_node == render_node) {
-                    render_node = phys_node->next;
-                    if(render_node == 0) {
-                        render_node = objects->front;
-                    }
+            pushHeap(&stale_heap, i, priority);
+        }
+        num_scheduled = 0;
+        return bodies.count;
+    }
+
+    // only bodies that are due, nearest level first so a short budget
+    // is spent near the focus, still round robin within a level
+    lod_level = growPairBuffer(lod_level, &lod_level_capacity, bodies.count, sizeof(int));
+    int start[LOD_LEVELS + 1] = {0};
+    for(int k = 0; k < bodies.count; k ++) {
+        int i = (phys_index + k) % bodies.count;
+        int level = lodLevel(i);
+
+        bodies.skipped[i] ++;
+        if(bodies.skipped[i] < 1 << level) {
+            lod_level[i] = -1;
+            continue;
+        }
+        lod_level[i] = level;
+        start[level + 1] ++;
+    }
+    for(int level = 0; level < LOD_LEVELS; level ++) {
+        start[level + 1] += start[level];
+    }
+
+    int n = start[LOD_LEVELS];
+    for(int k = 0; k < bodies.count; k ++) {
+        int i = (phys_index + k) % bodies.count;
+        if(lod_level[i] >= 0) {
+            gather_list[start[lod_level[i]] ++] = i;
+        }
+    }
+    num_scheduled = n;
+    return n;
+}
+
+// the k-th body scheduleBodies picked
+static int scheduledBody(int k) {
+    while(num_scheduled <= k) {
+        gather_list[num_scheduled ++] = popHeap(&stale_heap);
+    }
+    return gather_list[k];
+}
+
+// each body steps by the time since it was last updated, within runtime
+// a body the schedule leaves out keeps its clock, so its next step covers
+// every pass it missed
+static void updateVariable(struct List *objects, float runtime, uint64_t now) {
+    int num_removed = 0;
+
+    step_end = now;
+    prepareBroadphase();
+    clearIslands(&islands, bodies.count);
+    stats.sleeping = 0;
+
+    // how long the stalest body has waited, before this pass gets to it
+    uint64_t oldest = now;
+    for(int i = 0; i < bodies.count; i ++) {
+        if(bodies.last_update_time[i] < oldest) {
+            oldest = bodies.last_update_time[i];
+        }
+    }
+    if(ticksToSeconds(now - oldest) > stats.max_staleness) {
+        stats.max_staleness = ticksToSeconds(now - oldest);
+    }
+
+    int n = scheduleBodies(now);
+    lod_pass = schedule == SCHEDULE_LOD;
+    collideStatics();
+    lod_pass = 0;
+
+    int processed = 0;
+    if(phys_threads > 1) {
+        // the runs need the whole order up front
+        if(n > 0) {
+            scheduledBody(n - 1);
+        }
+        processed = stepParallel(n, now, runtime, 0, &num_removed);
+    }
+    else {
+        // batches sized from the cost per body so far, not a clock read per body
+        startBudget(&visit_budget, now, runtime);
+        int batch = 0;
+        while(processed < n && (batch = nextBatch(&visit_budget, batch)) > 0) {
+            batch = min(batch, n - processed);
+            for(int k = 0; k < batch; k ++) {
+                int i = scheduledBody(processed);
+
+                if(bodies.sleeping[i]) {
+                    // keep the clock current so waking up is not one huge step
+                    bodies.last_update_time[i] = now;
                 }
-                phys_node = phys_node->next;
-                if(phys_node == 0) {
-                    phys_node = objects->front;
+                else if(stepBody(i, ticksToSeconds(now - bodies.last_update_time[i]))) {
+                    queueRemoval(i, &num_removed);
                 }
-                removeNode(objects, temp);
-                continue;
-            }
-            else {
-                ((struct Circle *)phys_node->data)->last_update_time = glfwGetTime();
+                processed ++;
             }
         }
+    }
+    if(visit_budget.overrun > stats.max_overrun) {
+        stats.max_overrun = visit_budget.overrun;
+    }
+
+    for(int k = 0; k < processed; k ++) {
+        bodies.skipped[gather_list[k]] = 0;
+    }
+    if(bodies.count > 0) {
+        phys_index = (phys_index + processed) % bodies.count;
+    }
+
+    updateSleep();
+    removeBodies(objects, removed, num_removed);
+
+    // positions are drawn as they are
+    interp_alpha = 1.0f;
+    memcpy(bodies.prev_x, bodies.pos_x, bodies.count * sizeof(float));
+    memcpy(bodies.prev_y, bodies.pos_y, bodies.count * sizeof(float));
+}
+
+// builds whatever the static geometry needs before a step
+static void prepareStatics(uint64_t now) {
+    if(static_dirty) {
+        buildStatics();
+    }
+    if(static_collision == STATIC_SDF && !sdf_baked) {
+        bakeStatics();
+    }
+    fadeStatics(now);
+}
+
+// updates physics of all these objects
+int updatePhysics(struct List *objects, float runtime) {
+    uint64_t now = getTicks();
 
-        phys_node = phys_node->next;
-        if(phys_node == 0) {
-            phys_node = objects->front;
+    prepareStatics(now);
+
+    // deterministic ticks keep counting with nothing to step, the tick callback may spawn
+    if(bodies.count == 0 && step_mode != STEP_DETERMINISTIC) {
+        last_step_time = now;
+        step_end = now;
+        accumulator = 0;
+        return 0;
+    }
+
+    if(step_mode == STEP_VARIABLE) {
+        updateVariable(objects, runtime, now);
+    }
+    else {
+        updateFixed(objects, runtime, now);
+    }
+
+    stats.steps ++;
+    stats.step_time += ticksToSeconds(getTicks() - now);
+
+    return 0;
+}
+
+int stepPhysics(struct List *objects) {
+    prepareStatics(step_end + secondsToTicks(FIXED_DT));
+    if(bodies.count > 0 || step_mode == STEP_DETERMINISTIC) {
+        fixedStep(objects);
+    }
+    else {
+        step_end += secondsToTicks(FIXED_DT);
+    }
+    interp_alpha = 1.0f;
+
+    return 0;
+}
+
+void clearObjects(struct List *objects) {
+    // last body first, so none of them gets moved
+    for(int i = bodies.count - 1; i >= 0; i --) {
+        if(sap_initialized) {
+            removeSapProxy(&sap, bodies.proxy[i]);
         }
-        if(start_node == 0) {
-            start_node = objects->front;
+        removeNode(objects, bodies.node[i]);
+        removeBody(&bodies, i);
+    }
+    focus_node = 0;
+    phys_index = 0;
+}
+
+void setBroadphase(int mode) {
+    if(mode >= 0 && mode < NUM_BROADPHASES) {
+        broadphase = mode;
+    }
+}
+
+int getBroadphase() {
+    return broadphase;
+}
+
+void setStepMode(int mode) {
+    if(mode < 0 || mode >= NUM_STEP_MODES || mode == step_mode) {
+        return;
+    }
+    step_mode = mode;
+
+    // start the new mode from now so nobody takes a step covering the other mode's time
+    uint64_t now = getTicks();
+    accumulator = 0;
+    last_step_time = now;
+    step_end = now;
+    for(int i = 0; i < bodies.count; i ++) {
+        bodies.last_update_time[i] = now;
+    }
+
+    // deterministic steps take over from wherever the floats are
+    if(mode == STEP_DETERMINISTIC) {
+        phys_tick = 0;
+        for(int i = 0; i < bodies.count; i ++) {
+            bodies.fx_pos_x[i] = toFixed(bodies.pos_x[i]);
+            bodies.fx_pos_y[i] = toFixed(bodies.pos_y[i]);
+            bodies.fx_vel_x[i] = toFixed(bodies.vel_x[i]);
+            bodies.fx_vel_y[i] = toFixed(bodies.vel_y[i]);
+            bodies.fx_sleep_x[i] = bodies.fx_pos_x[i];
+            bodies.fx_sleep_y[i] = bodies.fx_pos_y[i];
+            bodies.still_steps[i] = 0;
         }
+        mirrorFixed();
     }
+}
 
-    return 0;
+int getStepMode() {
+    return step_mode;
+}
+
+void setTickCallback(TickFunc func, void *arg) {
+    tick_func = func;
+    tick_arg = arg;
+}
+
+uint64_t getPhysTick() {
+    return phys_tick;
+}
+
+uint32_t hashPhysState() {
+    // fnv-1a over every body's fixed position and velocity
+    uint32_t h = 2166136261u;
+    for(int i = 0; i < bodies.count; i ++) {
+        fixed state[4] = {bodies.fx_pos_x[i], bodies.fx_pos_y[i], bodies.fx_vel_x[i], bodies.fx_vel_y[i]};
+        for(int k = 0; k < 4; k ++) {
+            for(int byte = 0; byte < 4; byte ++) {
+                h ^= ((uint32_t)state[k] >> (byte * 8)) & 0xff;
+                h *= 16777619u;
+            }
+        }
+    }
+    return h;
+}
+
+void setSolver(int mode) {
+    if(mode >= 0 && mode < NUM_SOLVERS) {
+        solver_mode = mode;
+    }
+}
+
+int getSolver() {
+    return solver_mode;
+}
+
+void setSolverIterations(int iterations) {
+    if(iterations > 0) {
+        solver_iterations = iterations;
+    }
+}
+
+int getSolverIterations() {
+    return solver_iterations;
+}
+
+void setPhysThreads(int threads) {
+    if(threads > 0) {
+        phys_threads = threads;
+    }
+}
+
+int getPhysThreads() {
+    return phys_threads;
+}
+
+void setPhysJobs(struct Jobs *js) {
+    jobs = js;
+}
+
+void setSchedule(int mode) {
+    if(mode >= 0 && mode < NUM_SCHEDULES) {
+        schedule = mode;
+    }
+}
+
+int getSchedule() {
+    return schedule;
+}
+
+void setStalenessSpeedWeight(float weight) {
+    if(weight >= 0) {
+        stale_speed_weight = weight;
+    }
+}
+
+void setFocusCircle(struct Node *node) {
+    focus_node = node;
+}
+
+void setFocusPoint(float x, float y) {
+    focus_x = x;
+    focus_y = y;
+    focus_point_set = 1;
+}
+
+void setStaticCollision(int mode) {
+    if(mode >= 0 && mode < NUM_STATIC_COLLISIONS) {
+        static_collision = mode;
+    }
+}
+
+int getStaticCollision() {
+    return static_collision;
+}
+
+void setPairWork(int work) {
+    pair_work = work;
+}
+
+void getPhysStats(struct PhysStats *out) {
+    *out = stats;
+    memset(&stats, 0, sizeof(stats));
 }
 
 float dist(float x1, float y1, float x2, float y2) {
@@ -273,22 +2206,14 @@ float lengthV2Squared(struct v2 *v) {
     return distSquared(v->x, v->y, 0, 0);
 }
 
-int isCollidingCircVCirc(struct Manifold *m) {
-
-    struct Circle *a, *b;
-    a = (struct Circle *)m->a;
-    b = (struct Circle *)m->b;
-
-    if(a->inv_mass == 0 && b->inv_mass == 0) {
-        return 0;
-    }
-
+// shared circle overlap test, a at ax, ay and b at bx, by
+static int circleContact(float ax, float ay, float ar, float bx, float by, float br, struct Manifold *m) {
     // vector from a to b
     struct v2 n;
-    n.x = b->pos.x - a->pos.x;
-    n.y = b->pos.y - a->pos.y;
+    n.x = bx - ax;
+    n.y = by - ay;
 
-    float r = a->radius + b->radius;
+    float r = ar + br;
     r *= r;
 
     // if dist from a to b squared is greater than r squared
@@ -300,14 +2225,14 @@ int isCollidingCircVCirc(struct Manifold *m) {
 
     // if circles are not at the exact same position
     if(d != 0) {
-        m->penetration = a->radius + b->radius - d;
+        m->penetration = ar + br - d;
 
         m->norm.x = n.x / d;
         m->norm.y = n.y / d;
     }
     else {
         // circles are directly on top of eachother, just pick something
-        m->penetration = a->radius;
+        m->penetration = ar;
         m->norm.x = 1.0f;
         m->norm.y = 0.0f;
     }
@@ -315,28 +2240,48 @@ int isCollidingCircVCirc(struct Manifold *m) {
     return 1;
 }
 
-int isCollidingCircVRect(struct Manifold *m) {
-    struct Circle *c = (struct Circle *)m->a;
-    struct Rect *r = (struct Rect *)m->b;
+int isCollidingCircVCirc(struct Bodies *b, struct Manifold *m) {
+    int a = m->a;
+    int o = m->b;
+
+    if(b->inv_mass[a] == 0 && b->inv_mass[o] == 0) {
+        return 0;
+    }
+
+    return circleContact(b->pos_x[a], b->pos_y[a], b->radius[a], b->pos_x[o], b->pos_y[o], b->radius[o], m);
+}
+
+int isCollidingCircVStatic(struct Bodies *b, struct Manifold *m, struct Circle *c) {
+    int a = m->a;
 
-    if(c->inv_mass == 0) {
-        //return 0;
+    if(b->inv_mass[a] == 0) {
+        return 0;
     }
 
+    return circleContact(b->pos_x[a], b->pos_y[a], b->radius[a], c->pos.x, c->pos.y, c->radius, m);
+}
+
+int isCollidingCircVRect(struct Bodies *b, struct Manifold *m, struct Rect *r) {
+    int a = m->a;
+    struct v2 pos;
+    pos.x = b->pos_x[a];
+    pos.y = b->pos_y[a];
+    float radius = b->radius[a];
+
     // vector from a to b
     struct v2 n;
-    n.x = c->pos.x - r->pos.x;
-    n.y = c->pos.y - r->pos.y;
+    n.x = pos.x - r->pos.x;
+    n.y = pos.y - r->pos.y;
 
     // closest point on a to center of b
     struct v2 closest;
-    closest.x = clamp(c->pos.x, r->pos.x, r->pos.x + r->length);
-    closest.y = clamp(c->pos.y, r->pos.y, r->pos.y + r->height);
+    closest.x = clamp(pos.x, r->pos.x, r->pos.x + r->length);
+    closest.y = clamp(pos.y, r->pos.y, r->pos.y + r->height);
 
     int inside = 0;
 
     // if the center of the circle is in the rectangle
-    if(c->pos.x == closest.x && c->pos.y== closest.y) {
+    if(pos.x == closest.x && pos.y == closest.y) {
         inside = 1;
         // find the closest edge and set closest to be there
         // (Probably a better way to do this...)
@@ -360,12 +2305,12 @@ int isCollidingCircVRect(struct Manifold *m) {
     }
 
     struct v2 normal;
-    normal.x = closest.x - c->pos.x;
-    normal.y = closest.y - c->pos.y;
+    normal.x = closest.x - pos.x;
+    normal.y = closest.y - pos.y;
     float d = lengthV2Squared(&normal);
 
     // circle not in rectangle
-    if(!inside && d > c->radius * c->radius) {
+    if(!inside && d > radius * radius) {
         return 0;
     }
 
@@ -378,11 +2323,11 @@ int isCollidingCircVRect(struct Manifold *m) {
     if(inside) {
         m->norm.x = (-1 * normal.x) / d;
         m->norm.y = (-1 * normal.y) / d;
-        m->penetration = c->radius - d;
+        m->penetration = radius - d;
     } else {
         m->norm.x = normal.x / d;
         m->norm.y = normal.y / d;
-        m->penetration = c->radius - d;
+        m->penetration = radius - d;
     }
 
     if(isnan(m->norm.x) || isnan(m->norm.y)) {
@@ -394,25 +2339,23 @@ int isCollidingCircVRect(struct Manifold *m) {
 }
 
 // called when two circles are colliding
-int collideCirc(struct Manifold *m) {
-
-    struct Circle *a, *b;
-    a = (struct Circle *)m->a;
-    b = (struct Circle *)m->b;
+int collideCirc(struct Bodies *b, struct Manifold *m) {
+    int a = m->a;
+    int o = m->b;
 
     // don't let static objects collide
-    if(a->inv_mass == 0 && b->inv_mass == 0) {
+    if(b->inv_mass[a] == 0 && b->inv_mass[o] == 0) {
         return 1;
     }
 
     // relative velocity
     struct v2 rv;
-    rv.x = b->vel.x - a->vel.x;
-    rv.y = b->vel.y - a->vel.y;
+    rv.x = b->vel_x[o] - b->vel_x[a];
+    rv.y = b->vel_y[o] - b->vel_y[a];
 
     float vel_norm = rv.x * m->norm.x + rv.y * m->norm.y;
-    if(a->explosive || b->explosive) {
-        vel_norm -= 250;
+    if(b->explosive[a] || b->explosive[o]) {
+        vel_norm -= EXPLOSIVE_SPEED;
     }
 
     // do not collide if velocities are separating
@@ -421,57 +2364,55 @@ int collideCirc(struct Manifold *m) {
     }
 
     // update color for cool effects
-    #define DV 10
-    a->color.y -= abs(vel_norm / DV);
-    a->color.z -= abs(vel_norm / DV);
-    if(a->color.y < 0) {
-        a->color.y = 0;
+    b->color_g[a] -= fabsf(vel_norm / DV);
+    b->color_b[a] -= fabsf(vel_norm / DV);
+    if(b->color_g[a] < 0) {
+        b->color_g[a] = 0;
     }
-    if(a->color.z < 0) {
-        a->color.z = 0;
+    if(b->color_b[a] < 0) {
+        b->color_b[a] = 0;
     }
-    b->color.y -= abs(vel_norm / DV);
-    b->color.z -= abs(vel_norm / DV);
-    if(b->color.y < 0) {
-        b->color.y = 0;
+    b->color_g[o] -= fabsf(vel_norm / DV);
+    b->color_b[o] -= fabsf(vel_norm / DV);
+    if(b->color_g[o] < 0) {
+        b->color_g[o] = 0;
     }
-    if(b->color.z < 0) {
-        b->color.z = 0;
+    if(b->color_b[o] < 0) {
+        b->color_b[o] = 0;
     }
 
     // use the lowest restitution (bounciness)
-    float e = min(a->restitution, b->restitution);
+    float e = min(b->restitution[a], b->restitution[o]);
 
     // calculate impulse scalar
     float j = -(1 + e) * vel_norm;
-    j /= a->inv_mass + b->inv_mass;
+    j /= b->inv_mass[a] + b->inv_mass[o];
 
     // Apply impulse
     struct v2 impulse;
     impulse.x = j * m->norm.x;
     impulse.y = j * m->norm.y;
-    a->vel.x -= a->inv_mass * impulse.x;
-    a->vel.y -= a->inv_mass * impulse.y;
-    b->vel.x += b->inv_mass * impulse.x;
-    b->vel.y += b->inv_mass * impulse.y;
+    b->vel_x[a] -= b->inv_mass[a] * impulse.x;
+    b->vel_y[a] -= b->inv_mass[a] * impulse.y;
+    b->vel_x[o] += b->inv_mass[o] * impulse.x;
+    b->vel_y[o] += b->inv_mass[o] * impulse.y;
 
     return 0;
 }
 
-// called when two circles are colliding
-int collideCircVRect(struct Manifold *m) {
-    struct Circle *c;
-    c = (struct Circle *)m->a;
+// called when a circle hits something that does not move
+int collideCircVRect(struct Bodies *b, struct Manifold *m) {
+    int a = m->a;
 
     // don't let static objects collide
-    if(c->inv_mass == 0) {
+    if(b->inv_mass[a] == 0) {
         return 1;
     }
 
     // relative velocity
     struct v2 rv;
-    rv.x = -1 * c->vel.x;
-    rv.y = -1 * c->vel.y;
+    rv.x = -1 * b->vel_x[a];
+    rv.y = -1 * b->vel_y[a];
 
     float vel_norm = rv.x * m->norm.x + rv.y * m->norm.y;
 
@@ -481,70 +2422,67 @@ int collideCircVRect(struct Manifold *m) {
     }
 
     // update color for cool effects
-    #define DV 10
-    c->color.y -= abs(vel_norm / DV);
-    c->color.z -= abs(vel_norm / DV);
-    if(c->color.y < 0) {
-        c->color.y = 0;
+    b->color_g[a] -= fabsf(vel_norm / DV);
+    b->color_b[a] -= fabsf(vel_norm / DV);
+    if(b->color_g[a] < 0) {
+        b->color_g[a] = 0;
     }
-    if(c->color.z < 0) {
-        c->color.z = 0;
+    if(b->color_b[a] < 0) {
+        b->color_b[a] = 0;
     }
 
     // use the lowest restitution (bounciness)
-    float e = min(c->restitution, 1.0f);
+    float e = min(b->restitution[a], 1.0f);
 
     // calculate impulse scalar
     float j = -(1 + e) * vel_norm;
-    j /= c->inv_mass;
+    j /= b->inv_mass[a];
 
     // Apply impulse
     struct v2 impulse;
     impulse.x = j * m->norm.x;
     impulse.y = j * m->norm.y;
-    c->vel.x -= c->inv_mass * impulse.x;
-    c->vel.y -= c->inv_mass * impulse.y;
+    b->vel_x[a] -= b->inv_mass[a] * impulse.x;
+    b->vel_y[a] -= b->inv_mass[a] * impulse.y;
 
     return 0;
 }
 
-int posCorCircVCirc(struct Manifold *m) {
-    struct Circle *a, *b;
-    a = (struct Circle *)m->a;
-    b = (struct Circle *)m->b;
+int posCorCircVCirc(struct Bodies *b, struct Manifold *m) {
+    int a = m->a;
+    int o = m->b;
 
     float percent = 0.8;
     float slop = 0.01;
     struct v2 correction;
-    float corr_factor = max(m->penetration - slop, 0.0f) / (a->inv_mass + b->inv_mass) * percent;
+    float corr_factor = max(m->penetration - slop, 0.0f) / (b->inv_mass[a] + b->inv_mass[o]) * percent;
     correction.x = corr_factor * m->norm.x;
     correction.y = corr_factor * m->norm.y;
 
-    a->pos.x -= a->inv_mass * correction.x;
-    a->pos.y -= a->inv_mass * correction.y;
-    b->pos.x += b->inv_mass * correction.x;
-    b->pos.y += b->inv_mass * correction.y;
+    b->pos_x[a] -= b->inv_mass[a] * correction.x;
+    b->pos_y[a] -= b->inv_mass[a] * correction.y;
+    b->pos_x[o] += b->inv_mass[o] * correction.x;
+    b->pos_y[o] += b->inv_mass[o] * correction.y;
 
     return 0;
 }
 
-int posCorCircVRect(struct Manifold *m) {
-    struct Circle *c;
-    c = (struct Circle *)m->a;
+int posCorCircVRect(struct Bodies *b, struct Manifold *m) {
+    int a = m->a;
 
-    if(c->inv_mass == 0) {
+    if(b->inv_mass[a] == 0) {
         return 1;
     }
 
     float percent = 0.8;
     float slop = 0.01;
     struct v2 correction;
-    float corr_factor = max(m->penetration - slop, 0.0f) / (c->inv_mass) * percent;
+    float corr_factor = max(m->penetration - slop, 0.0f) / (b->inv_mass[a]) * percent;
     correction.x = corr_factor * m->norm.x;
     correction.y = corr_factor * m->norm.y;
 
-    c->pos.x -= c->inv_mass * correction.x;
-    c->pos.y -= c->inv_mass * correction.y;
+    b->pos_x[a] -= b->inv_mass[a] * correction.x;
+    b->pos_y[a] -= b->inv_mass[a] * correction.y;
 
     return 0;
 }
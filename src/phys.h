@@ -2,20 +2,67 @@
 #define PHYS_H
 
 #include <math.h>
-#include <cglm/cglm.h>
 
-#include "sprite.h"
 #include "list.h"
+#include "bodies.h"
+#include "grid.h"
+#include "sap.h"
+#include "bvh.h"
+#include "sdf.h"
+#include "narrow.h"
+#include "island.h"
+#include "solver.h"
+#include "jobs.h"
+#include "snapshot.h"
+#include "heap.h"
+#include "budget.h"
+#include "timer.h"
 #include "const.h"
 
 #define CIRC_TYPE 0
 #define RECT_TYPE 1
 
+// broadphase used by updatePhysics
+#define BROADPHASE_LIST 0   // every node against every other node
+#define BROADPHASE_GRID 1   // uniform spatial hash rebuilt each call
+#define BROADPHASE_SAP 2    // sweep and prune kept sorted between calls
+#define NUM_BROADPHASES 3
+
+// how moving circles are tested against static geometry
+#define STATIC_ANALYTIC 0   // exact tests against bodies found in the bvh
+#define STATIC_SDF 1        // one lookup in a baked distance field
+#define NUM_STATIC_COLLISIONS 2
+
+// how updatePhysics advances time
+#define STEP_VARIABLE 0     // each body steps by its own time since last update
+#define STEP_FIXED 1        // whole fixed steps from an accumulator, drawing interpolates
+#define STEP_DETERMINISTIC 2    // fixed steps in Q16.16, the same bits on every machine
+#define NUM_STEP_MODES 3
+
+// length of a STEP_FIXED or STEP_DETERMINISTIC step
+#define FIXED_DT (1.0f / 60.0f)
+
+// called before each STEP_DETERMINISTIC step with the step's number
+// anything that changes the world, like spawning, has to happen here
+// to land on the same step every run
+typedef void (*TickFunc)(struct List *objects, uint64_t tick, void *arg);
+
+// how fixed steps resolve contacts, variable steps are always immediate
+#define SOLVER_IMMEDIATE 0      // one impulse per contact as soon as it is found
+#define SOLVER_SEQUENTIAL 1     // gather the step's contacts, then iterate with warm starting
+#define SOLVER_PARALLEL 2       // sequential, with graph colored batches spread over threads
+#define NUM_SOLVERS 3
+
+// order and rate of the per body updates in STEP_VARIABLE
+// fixed steps always move every awake body together
+#define SCHEDULE_ROUND_ROBIN 0      // every body, every pass
+#define SCHEDULE_LOD 1              // far from the focus bodies are visited less often
+#define SCHEDULE_STALEST 2          // longest waiting first, so nobody waits much past a pass
+#define NUM_SCHEDULES 3
+
 // Inspiration:
 // https://gamedevelopment.tutsplus.com/tutorials/how-to-create-a-custom-2d-physics-engine-the-basics-and-impulse-resolution--gamedev-6331
 
-extern double glfwGetTime();
-
 struct v2 {
     float x;
     float y;
@@ -27,20 +74,15 @@ struct v3 {
     float z;
 };
 
+// a static circle, moving circles live in struct Bodies
 struct Circle {
     // rendering variables
     struct v3 color;
 
-    // physics variables 
+    // physics variables
     struct v2 pos;
-    struct v2 vel;
     float radius;
-    float mass;
-    float inv_mass;    // calculate in init
     float restitution; // == bounciness
-    int explosive;
-
-    float last_update_time;
 };
 
 struct Rect {
@@ -53,43 +95,129 @@ struct Rect {
     float restitution;
 };
 
+// a is always a moving body, b is a body index or a static id
 struct Manifold {
-    void *a;
-    void *b;
+    int a;
+    int b;
     float penetration;
     struct v2 norm;
 };
 
+// counters collected by updatePhysics
+struct PhysStats {
+    unsigned long pair_tests;       // narrow phase tests run
+    unsigned long contacts;         // tests that found a collision
+    unsigned long bodies_updated;   // circles integrated
+    unsigned long sleeping;         // circles asleep after the last pass
+    unsigned long steps;            // calls to updatePhysics
+    float step_time;                // seconds spent in those calls
+    float max_staleness;            // longest a body waited for a variable step
+    float max_overrun;              // furthest a variable step went past its runtime
+};
+
 // must be called before any objects are added
-int initPhysRenderer(struct TexMan *texman, struct Shader *shdr);
+// nothing here needs gl, drawing is in draw.h and initPhysRenderer calls this
+int initPhysics();
 
 // add circle to the world
+// the returned node is a handle to the circle, its data is the body index
 struct Node *addCircle(struct List *objects, float x, float y, float xv, float yv, float radius, float mass);
+void translateCircle(struct Node *node, float dx, float dy);
+void setCircleExplosive(struct Node *node, int explosive);
+
+// static geometry lives outside the objects list in a prebuilt bvh
+// only moving circles are tested against it
+// both return an id for removeStatic, or -1 on error
+int addRect(float x, float y, float l, float h);
+int addStaticCircle(float x, float y, float radius);
+int removeStatic(int id);
+
+
+
+// removes every object in the list
+void clearObjects(struct List *objects);
 
-// Add rectangle to objects list
-int addRect(struct List *objects, float x, float y, float l, float h);
+// copies the counters since the last call into stats and resets them
+void getPhysStats(struct PhysStats *stats);
 
 
 
-// Rendering stuff
-// draws all objecs in list to the screen
-int drawObjects(struct List *objects, float runtime);
-int drawCircle(struct Circle *c);
-int drawRect(struct Rect *r);
+// for drawing, fill a snapshot between updates, see draw.h
+// it only reads the world, so it can be drawn on another thread
+void writeSnapshot(struct Snapshot *s);
 
 
 
 // Physics stuff
 
-// returns 1 if this circle is offscreen, 0 otherwise
-int updateCircle(struct Circle *c, float dt);
+// returns 1 if body i is offscreen, 0 otherwise
+int updateCircle(struct Bodies *b, int i, float dt);
+// same as updateCircle without adding gravity
+int moveCircle(struct Bodies *b, int i, float dt);
 int updatePhysics(struct List *objects, float runtime);
-int isCollidingCircVCirc(struct Manifold *m);
-int isCollidingCircVRect(struct Manifold *m);
-int collideCirc(struct Manifold *m);
-int collideCircVRect(struct Manifold *m);
-int posCorCircVCirc(struct Manifold *m);
-int posCorCircVRect(struct Manifold *m);
+// takes exactly one fixed step now, as STEP_FIXED or STEP_DETERMINISTIC would,
+// for running without a clock
+int stepPhysics(struct List *objects);
+int isCollidingCircVCirc(struct Bodies *b, struct Manifold *m);
+int isCollidingCircVStatic(struct Bodies *b, struct Manifold *m, struct Circle *c);
+int isCollidingCircVRect(struct Bodies *b, struct Manifold *m, struct Rect *r);
+int collideCirc(struct Bodies *b, struct Manifold *m);
+int collideCircVRect(struct Bodies *b, struct Manifold *m);
+int posCorCircVCirc(struct Bodies *b, struct Manifold *m);
+int posCorCircVRect(struct Bodies *b, struct Manifold *m);
+
+// select one of the BROADPHASE_ modes
+void setBroadphase(int mode);
+int getBroadphase();
+
+// select one of the STEP_ modes
+// STEP_DETERMINISTIC starts from the float state, for runs that match from the
+// start select it before adding anything
+void setStepMode(int mode);
+int getStepMode();
+
+void setTickCallback(TickFunc func, void *arg);
+
+// STEP_DETERMINISTIC steps taken since it was selected
+uint64_t getPhysTick();
+
+// hash of the STEP_DETERMINISTIC state, equal hashes at equal ticks mean equal runs
+uint32_t hashPhysState();
+
+// select one of the SOLVER_ modes
+void setSolver(int mode);
+int getSolver();
+
+// passes the sequential solver makes over the contacts each step
+void setSolverIterations(int iterations);
+int getSolverIterations();
+
+// most jobs the loops finding contacts and SOLVER_PARALLEL are split into,
+// at most one per job system worker, 1 keeps everything on the caller
+void setPhysThreads(int threads);
+int getPhysThreads();
+
+// runs physics jobs on js instead of a job system of its own
+// must be called before the first update
+void setPhysJobs(struct Jobs *js);
+
+// select one of the SCHEDULE_ modes
+void setSchedule(int mode);
+int getSchedule();
+
+// SCHEDULE_STALEST favours fast bodies by 1 + weight * speed, 0 by default
+void setStalenessSpeedWeight(float weight);
+
+// SCHEDULE_LOD measures from the nearer of the focus circle and the focus point
+void setFocusCircle(struct Node *node);
+void setFocusPoint(float x, float y);
+
+// select one of the STATIC_ modes, the field is baked on first use
+void setStaticCollision(int mode);
+int getStaticCollision();
+
+// busy loop iterations run per pair test, 0 disables it
+void setPairWork(int work);
 
 
 #endif
\ No newline at end of file
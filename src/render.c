@@ -0,0 +1,153 @@
+#include "render.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RADIX_BITS 8
+#define RADIX_SIZE (1 << RADIX_BITS)
+
+// ********** private functions **********
+
+static void *growArray(void *arr, int capacity, int size) {
+    void *temp = realloc(arr, capacity * size);
+    if(temp == 0) {
+        printf("error allocating memory for render queue\n");
+        exit(1);
+    }
+    return temp;
+}
+
+// least significant digit first, each pass is stable so the result is too
+// passes where every key has the same digit are skipped, which with few
+// distinct programs and textures is most of them
+static void sortCommands(struct RenderQueue *q) {
+    int n = q->count;
+    if(n > q->sort_capacity) {
+        q->sort_capacity = n;
+        q->keys = growArray(q->keys, n, sizeof(uint64_t));
+        q->order = growArray(q->order, n, sizeof(int));
+        q->scratch_keys = growArray(q->scratch_keys, n, sizeof(uint64_t));
+        q->scratch_order = growArray(q->scratch_order, n, sizeof(int));
+    }
+
+    for(int i = 0; i < n; i ++) {
+        q->keys[i] = q->commands[i].key;
+        q->order[i] = i;
+    }
+
+    for(int shift = 0; shift < 64; shift += RADIX_BITS) {
+        int counts[RADIX_SIZE];
+        memset(counts, 0, sizeof(counts));
+        for(int i = 0; i < n; i ++) {
+            counts[(q->keys[i] >> shift) & (RADIX_SIZE - 1)] ++;
+        }
+        if(counts[(q->keys[0] >> shift) & (RADIX_SIZE - 1)] == n) {
+            continue;
+        }
+
+        int start = 0;
+        for(int d = 0; d < RADIX_SIZE; d ++) {
+            int c = counts[d];
+            counts[d] = start;
+            start += c;
+        }
+        for(int i = 0; i < n; i ++) {
+            int j = counts[(q->keys[i] >> shift) & (RADIX_SIZE - 1)] ++;
+            q->scratch_keys[j] = q->keys[i];
+            q->scratch_order[j] = q->order[i];
+        }
+
+        uint64_t *keys = q->keys;
+        int *order = q->order;
+        q->keys = q->scratch_keys;
+        q->order = q->scratch_order;
+        q->scratch_keys = keys;
+        q->scratch_order = order;
+    }
+}
+
+// b can be drawn in the same call as a
+static int canMerge(struct DrawCommand *a, struct DrawCommand *b) {
+    return a->program == b->program && a->texture == b->texture && a->VAO == b->VAO
+        && a->vertices == b->vertices && a->prepare == b->prepare && a->arg == b->arg
+        && a->base + a->instances == b->base;
+}
+
+// ********** public functions **********
+
+int initRenderQueue(struct RenderQueue *q) {
+    memset(q, 0, sizeof(*q));
+    return 0;
+}
+
+uint64_t drawKey(uint32_t program, uint32_t texture, uint32_t VAO, uint32_t depth) {
+    uint64_t key = program & ((1u << DRAW_KEY_PROGRAM_BITS) - 1);
+    key = key << DRAW_KEY_TEXTURE_BITS | (texture & ((1u << DRAW_KEY_TEXTURE_BITS) - 1));
+    key = key << DRAW_KEY_VAO_BITS | (VAO & ((1u << DRAW_KEY_VAO_BITS) - 1));
+    key = key << DRAW_KEY_DEPTH_BITS | (depth & ((1u << DRAW_KEY_DEPTH_BITS) - 1));
+    return key;
+}
+
+struct DrawCommand *pushDrawCommand(struct RenderQueue *q) {
+    if(q->count >= q->capacity) {
+        q->capacity = q->capacity == 0 ? 64 : q->capacity * 2;
+        q->commands = growArray(q->commands, q->capacity, sizeof(struct DrawCommand));
+    }
+    q->stats.commands ++;
+    return &q->commands[q->count ++];
+}
+
+void submitRenderQueue(struct RenderQueue *q) {
+    q->stats.submits ++;
+    if(q->count == 0) {
+        return;
+    }
+    sortCommands(q);
+
+    // whatever was bound before is unknown, so the first command binds everything
+    struct DrawCommand *bound = 0;
+    int i = 0;
+    while(i < q->count) {
+        struct DrawCommand draw = q->commands[q->order[i ++]];
+        while(i < q->count && canMerge(&draw, &q->commands[q->order[i]])) {
+            draw.instances += q->commands[q->order[i ++]].instances;
+        }
+
+        if(bound == 0 || draw.program != bound->program) {
+            glUseProgram(draw.program);
+            q->stats.program_changes ++;
+        }
+        if(bound == 0 || draw.texture != bound->texture) {
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, draw.texture);
+            q->stats.texture_changes ++;
+        }
+        if(bound == 0 || draw.VAO != bound->VAO) {
+            glBindVertexArray(draw.VAO);
+            q->stats.VAO_changes ++;
+        }
+        bound = &q->commands[q->order[i - 1]];
+
+        if(draw.prepare != 0) {
+            draw.prepare(draw.arg, draw.base);
+        }
+        glDrawArraysInstanced(GL_TRIANGLES, 0, draw.vertices, draw.instances);
+        q->stats.draws ++;
+    }
+
+    q->count = 0;
+}
+
+void getRenderStats(struct RenderQueue *q, struct RenderStats *stats) {
+    *stats = q->stats;
+    memset(&q->stats, 0, sizeof(q->stats));
+}
+
+void destroyRenderQueue(struct RenderQueue *q) {
+    free(q->commands);
+    free(q->keys);
+    free(q->order);
+    free(q->scratch_keys);
+    free(q->scratch_order);
+    initRenderQueue(q);
+}
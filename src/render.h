@@ -0,0 +1,78 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <glad/glad.h>
+
+// bits of a draw key, from the top: program, texture, VAO, depth
+// names are masked to their field, two names sharing a field only cost
+// a state change, submission always compares the real names
+#define DRAW_KEY_PROGRAM_BITS 12
+#define DRAW_KEY_TEXTURE_BITS 12
+#define DRAW_KEY_VAO_BITS 12
+#define DRAW_KEY_DEPTH_BITS 28
+
+// called after a command's state is bound and before it is drawn,
+// base is the command's first instance
+typedef void (*PrepareFunc)(void *arg, int base);
+
+// One instanced draw of a triangle list.
+struct DrawCommand {
+    uint64_t key;
+    uint32_t program;
+    uint32_t texture;
+    uint32_t VAO;
+    int vertices;           // per instance
+    int base;
+    int instances;
+    PrepareFunc prepare;    // 0 if there is nothing to do
+    void *arg;
+};
+
+// counters collected by submitRenderQueue
+struct RenderStats {
+    unsigned long submits;          // calls to submitRenderQueue, about one per frame
+    unsigned long commands;         // commands pushed
+    unsigned long draws;            // draw calls made, after merging
+    unsigned long program_changes;
+    unsigned long texture_changes;
+    unsigned long VAO_changes;
+};
+
+// Draw commands collected over a frame, sorted by key and submitted at once.
+// Sorting brings commands that share state together, so a program, texture
+// or VAO is only bound when it actually changes. Commands with equal state
+// and adjacent instances are drawn as one.
+struct RenderQueue {
+    struct DrawCommand *commands;
+    int count;
+    int capacity;
+
+    // key and command index pairs, sorted back and forth between the two
+    uint64_t *keys;
+    int *order;
+    uint64_t *scratch_keys;
+    int *scratch_order;
+    int sort_capacity;
+
+    struct RenderStats stats;
+};
+
+int initRenderQueue(struct RenderQueue *q);
+
+// lower keys are drawn first, depth orders commands that share all their state
+uint64_t drawKey(uint32_t program, uint32_t texture, uint32_t VAO, uint32_t depth);
+
+// makes room for one more command and returns it, the caller fills it in
+struct DrawCommand *pushDrawCommand(struct RenderQueue *q);
+
+// draws every command in key order and empties the queue
+void submitRenderQueue(struct RenderQueue *q);
+
+// copies the counters since the last call into stats and resets them
+void getRenderStats(struct RenderQueue *q, struct RenderStats *stats);
+
+void destroyRenderQueue(struct RenderQueue *q);
+
+#endif
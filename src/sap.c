@@ -0,0 +1,398 @@
+#include "sap.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define PAIR_EMPTY 0
+#define PAIR_DELETED 1
+
+// added endpoints past which a full sort beats insertion sort
+#define SAP_REBUILD_MIN 256
+
+// ********** private functions **********
+
+static void *growArray(void *arr, int new_capacity, int elem_size) {
+    void *temp = realloc(arr, new_capacity * elem_size);
+    if(temp == 0) {
+        printf("error allocating memory for sweep and prune\n");
+        exit(1);
+    }
+    return temp;
+}
+
+static uint64_t pairKey(int a, int b) {
+    if(a > b) {
+        int temp = a;
+        a = b;
+        b = temp;
+    }
+    // shifted so a key is never PAIR_EMPTY or PAIR_DELETED
+    return ((uint64_t)(a + 1) << 32) | (uint32_t)b;
+}
+
+static int pairSlot(struct Sap *s, uint64_t key) {
+    return (int)((key * 0x9E3779B97F4A7C15ull) >> 32) & (s->pairs_capacity - 1);
+}
+
+static void insertPairKey(struct Sap *s, uint64_t key);
+
+static void rehashPairs(struct Sap *s, int capacity) {
+    uint64_t *old = s->pairs;
+    int old_capacity = s->pairs_capacity;
+
+    s->pairs = calloc(capacity, sizeof(uint64_t));
+    if(s->pairs == 0) {
+        printf("error allocating memory for sweep and prune pairs\n");
+        exit(1);
+    }
+    s->pairs_capacity = capacity;
+    s->pair_count = 0;
+    s->pair_used = 0;
+
+    for(int i = 0; i < old_capacity; i ++) {
+        if(old[i] > PAIR_DELETED) {
+            insertPairKey(s, old[i]);
+        }
+    }
+    free(old);
+}
+
+static void insertPairKey(struct Sap *s, uint64_t key) {
+    // keep live plus deleted slots under three quarters
+    if((s->pair_used + 1) * 4 > s->pairs_capacity * 3) {
+        int capacity = s->pairs_capacity;
+        if((s->pair_count + 1) * 2 > capacity) {
+            capacity *= 2;
+        }
+        rehashPairs(s, capacity);
+    }
+
+    int i = pairSlot(s, key);
+    int deleted = -1;
+    while(s->pairs[i] != PAIR_EMPTY) {
+        if(s->pairs[i] == key) {
+            return;
+        }
+        if(s->pairs[i] == PAIR_DELETED && deleted == -1) {
+            deleted = i;
+        }
+        i = (i + 1) & (s->pairs_capacity - 1);
+    }
+
+    if(deleted != -1) {
+        i = deleted;
+    }
+    else {
+        s->pair_used ++;
+    }
+    s->pairs[i] = key;
+    s->pair_count ++;
+}
+
+static void removePairKey(struct Sap *s, uint64_t key) {
+    int i = pairSlot(s, key);
+    while(s->pairs[i] != PAIR_EMPTY) {
+        if(s->pairs[i] == key) {
+            s->pairs[i] = PAIR_DELETED;
+            s->pair_count --;
+            return;
+        }
+        i = (i + 1) & (s->pairs_capacity - 1);
+    }
+}
+
+static int overlaps(struct SapProxy *a, struct SapProxy *b) {
+    return a->min[0] <= b->max[0] && b->min[0] <= a->max[0]
+        && a->min[1] <= b->max[1] && b->min[1] <= a->max[1];
+}
+
+// min endpoints sort before max endpoints with the same value
+static int endpointGreater(struct SapEndpoint *a, struct SapEndpoint *b) {
+    if(a->value != b->value) {
+        return a->value > b->value;
+    }
+    return (a->data & 1) > (b->data & 1);
+}
+
+// insertion sort one axis, reporting overlaps as endpoints pass each other
+static void sortAxis(struct Sap *s, int axis) {
+    struct SapEndpoint *ep = s->axis[axis];
+
+    for(int i = 1; i < s->num_endpoints; i ++) {
+        struct SapEndpoint key = ep[i];
+        int j = i - 1;
+        while(j >= 0 && endpointGreater(&ep[j], &key)) {
+            int a = key.data >> 1;
+            int b = ep[j].data >> 1;
+            int key_max = key.data & 1;
+            int other_max = ep[j].data & 1;
+
+            // a min moving left past a max: may start overlapping
+            if(!key_max && other_max) {
+                if(overlaps(&s->proxies[a], &s->proxies[b])) {
+                    insertPairKey(s, pairKey(a, b));
+                }
+            }
+            // a max moving left past a min: stopped overlapping
+            else if(key_max && !other_max) {
+                removePairKey(s, pairKey(a, b));
+            }
+
+            ep[j + 1] = ep[j];
+            j --;
+        }
+        ep[j + 1] = key;
+    }
+}
+
+static int compareEndpoints(const void *a, const void *b) {
+    struct SapEndpoint *ea = (struct SapEndpoint *)a;
+    struct SapEndpoint *eb = (struct SapEndpoint *)b;
+    if(endpointGreater(ea, eb)) {
+        return 1;
+    }
+    if(endpointGreater(eb, ea)) {
+        return -1;
+    }
+    return 0;
+}
+
+// sorts from scratch and sweeps x for the pair set
+// used when too many proxies were added for insertion sort to be cheap
+static void rebuildPairs(struct Sap *s) {
+    qsort(s->axis[0], s->num_endpoints, sizeof(struct SapEndpoint), compareEndpoints);
+    qsort(s->axis[1], s->num_endpoints, sizeof(struct SapEndpoint), compareEndpoints);
+
+    memset(s->pairs, 0, s->pairs_capacity * sizeof(uint64_t));
+    s->pair_count = 0;
+    s->pair_used = 0;
+
+    // proxies whose x interval is open at the current endpoint
+    int *active = malloc(s->num_endpoints / 2 * sizeof(int) + sizeof(int));
+    int *slot = malloc(s->num_proxies * sizeof(int) + sizeof(int));
+    if(active == 0 || slot == 0) {
+        printf("error allocating memory for sweep and prune rebuild\n");
+        exit(1);
+    }
+    int num_active = 0;
+
+    struct SapEndpoint *ep = s->axis[0];
+    for(int i = 0; i < s->num_endpoints; i ++) {
+        int id = ep[i].data >> 1;
+        if(ep[i].data & 1) {
+            // swap remove from the active list
+            int last = active[-- num_active];
+            active[slot[id]] = last;
+            slot[last] = slot[id];
+        }
+        else {
+            for(int j = 0; j < num_active; j ++) {
+                if(overlaps(&s->proxies[id], &s->proxies[active[j]])) {
+                    insertPairKey(s, pairKey(id, active[j]));
+                }
+            }
+            slot[id] = num_active;
+            active[num_active ++] = id;
+        }
+    }
+
+    free(active);
+    free(slot);
+}
+
+// drops endpoints of removed proxies and frees their ids
+static void compactEndpoints(struct Sap *s) {
+    for(int axis = 0; axis < 2; axis ++) {
+        struct SapEndpoint *ep = s->axis[axis];
+        int n = 0;
+        for(int i = 0; i < s->num_endpoints; i ++) {
+            if(s->proxies[ep[i].data >> 1].alive == 1) {
+                ep[n ++] = ep[i];
+            }
+        }
+    }
+    s->num_endpoints -= s->num_dead * 2;
+
+    for(int i = 0; i < s->num_proxies; i ++) {
+        if(s->proxies[i].alive == 0) {
+            s->proxies[i].alive = -1;
+            s->free_proxies[s->num_free ++] = i;
+        }
+    }
+    s->num_dead = 0;
+}
+
+// turn the pair set into per proxy neighbor lists
+static void buildNeighbors(struct Sap *s) {
+    if(s->pair_count * 2 > s->adj_capacity) {
+        s->adj_capacity = s->pair_count * 4;
+        s->adj = growArray(s->adj, s->adj_capacity, sizeof(int));
+    }
+    s->adj_start = growArray(s->adj_start, s->num_proxies + 1, sizeof(int));
+
+    s->adj_proxies = s->num_proxies;
+    int *start = s->adj_start;
+    memset(start, 0, (s->num_proxies + 1) * sizeof(int));
+    for(int i = 0; i < s->pairs_capacity; i ++) {
+        if(s->pairs[i] > PAIR_DELETED) {
+            start[(int)(s->pairs[i] >> 32) - 1] ++;
+            start[(int)(s->pairs[i] & 0xffffffff)] ++;
+        }
+    }
+
+    // running sum puts start[i] at the end of list i, filling walks it back
+    int total = 0;
+    for(int i = 0; i <= s->num_proxies; i ++) {
+        total += start[i];
+        start[i] = total;
+    }
+    for(int i = 0; i < s->pairs_capacity; i ++) {
+        if(s->pairs[i] > PAIR_DELETED) {
+            int a = (int)(s->pairs[i] >> 32) - 1;
+            int b = (int)(s->pairs[i] & 0xffffffff);
+            s->adj[-- start[a]] = b;
+            s->adj[-- start[b]] = a;
+        }
+    }
+}
+
+// ********** public functions **********
+
+int initSap(struct Sap *s) {
+    s->axis[0] = 0;
+    s->axis[1] = 0;
+    s->num_endpoints = 0;
+    s->endpoints_capacity = 0;
+
+    s->proxies = 0;
+    s->num_proxies = 0;
+    s->proxies_capacity = 0;
+    s->free_proxies = 0;
+    s->num_free = 0;
+    s->num_dead = 0;
+    s->num_new = 0;
+
+    s->pairs = 0;
+    s->pairs_capacity = 0;
+    s->pair_count = 0;
+    s->pair_used = 0;
+    rehashPairs(s, 256);
+
+    s->adj_start = 0;
+    s->adj = 0;
+    s->adj_capacity = 0;
+    s->adj_proxies = 0;
+
+    return 0;
+}
+
+int addSapProxy(struct Sap *s, float min_x, float min_y, float max_x, float max_y, void *user) {
+    int id;
+
+    if(s->num_free > 0) {
+        id = s->free_proxies[-- s->num_free];
+    }
+    else {
+        if(s->num_proxies >= s->proxies_capacity) {
+            s->proxies_capacity = s->proxies_capacity == 0 ? 256 : s->proxies_capacity * 2;
+            s->proxies = growArray(s->proxies, s->proxies_capacity, sizeof(struct SapProxy));
+            s->free_proxies = growArray(s->free_proxies, s->proxies_capacity, sizeof(int));
+        }
+        id = s->num_proxies ++;
+    }
+
+    struct SapProxy *p = &s->proxies[id];
+    p->min[0] = min_x;
+    p->min[1] = min_y;
+    p->max[0] = max_x;
+    p->max[1] = max_y;
+    p->user = user;
+    p->alive = 1;
+
+    // appended unsorted, updateSap moves them into place
+    if(s->num_endpoints + 2 > s->endpoints_capacity) {
+        s->endpoints_capacity = s->endpoints_capacity == 0 ? 512 : s->endpoints_capacity * 2;
+        s->axis[0] = growArray(s->axis[0], s->endpoints_capacity, sizeof(struct SapEndpoint));
+        s->axis[1] = growArray(s->axis[1], s->endpoints_capacity, sizeof(struct SapEndpoint));
+    }
+    for(int axis = 0; axis < 2; axis ++) {
+        s->axis[axis][s->num_endpoints].value = p->min[axis];
+        s->axis[axis][s->num_endpoints].data = id << 1;
+        s->axis[axis][s->num_endpoints + 1].value = p->max[axis];
+        s->axis[axis][s->num_endpoints + 1].data = id << 1 | 1;
+    }
+    s->num_endpoints += 2;
+    s->num_new += 2;
+
+    return id;
+}
+
+void moveSapProxy(struct Sap *s, int id, float min_x, float min_y, float max_x, float max_y) {
+    struct SapProxy *p = &s->proxies[id];
+    p->min[0] = min_x;
+    p->min[1] = min_y;
+    p->max[0] = max_x;
+    p->max[1] = max_y;
+}
+
+void removeSapProxy(struct Sap *s, int id) {
+    if(id < 0 || id >= s->num_proxies || s->proxies[id].alive != 1) {
+        return;
+    }
+
+    // neighbor lists are exact between updates, so use them to find pairs
+    int count;
+    int *neighbors = getSapNeighbors(s, id, &count);
+    for(int i = 0; i < count; i ++) {
+        removePairKey(s, pairKey(id, neighbors[i]));
+    }
+
+    s->proxies[id].alive = 0;
+    s->num_dead ++;
+}
+
+void updateSap(struct Sap *s) {
+    if(s->num_dead > 0) {
+        compactEndpoints(s);
+    }
+
+    // pick up new bounds
+    for(int axis = 0; axis < 2; axis ++) {
+        struct SapEndpoint *ep = s->axis[axis];
+        for(int i = 0; i < s->num_endpoints; i ++) {
+            struct SapProxy *p = &s->proxies[ep[i].data >> 1];
+            ep[i].value = (ep[i].data & 1) ? p->max[axis] : p->min[axis];
+        }
+    }
+
+    if(s->num_new > SAP_REBUILD_MIN && s->num_new * 8 > s->num_endpoints) {
+        rebuildPairs(s);
+    }
+    else {
+        sortAxis(s, 0);
+        sortAxis(s, 1);
+    }
+    s->num_new = 0;
+
+    buildNeighbors(s);
+}
+
+int *getSapNeighbors(struct Sap *s, int id, int *count) {
+    // proxies added since the last update have no list yet
+    if(id >= s->adj_proxies) {
+        *count = 0;
+        return s->adj;
+    }
+    *count = s->adj_start[id + 1] - s->adj_start[id];
+    return s->adj + s->adj_start[id];
+}
+
+void destroySap(struct Sap *s) {
+    free(s->axis[0]);
+    free(s->axis[1]);
+    free(s->proxies);
+    free(s->free_proxies);
+    free(s->pairs);
+    free(s->adj_start);
+    free(s->adj);
+}
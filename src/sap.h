@@ -0,0 +1,70 @@
+#ifndef SAP_H
+#define SAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+// Sweep and prune broadphase.
+// Proxy endpoints stay sorted across updates, so when things only move a
+// little the insertion sort is close to linear. Overlaps start and end when
+// endpoints swap, which keeps a persistent set of overlapping pairs.
+// Both axes are sorted; a pair is only in the set while it overlaps on both.
+
+struct SapEndpoint {
+    float value;
+    int data;               // proxy id << 1 | 1 if this is a max endpoint
+};
+
+struct SapProxy {
+    float min[2];
+    float max[2];
+    void *user;
+    int alive;              // 1 in use, 0 removed, -1 free
+};
+
+struct Sap {
+    struct SapEndpoint *axis[2];
+    int num_endpoints;
+    int endpoints_capacity;
+
+    struct SapProxy *proxies;
+    int num_proxies;
+    int proxies_capacity;
+    int *free_proxies;
+    int num_free;
+    int num_dead;           // removed but endpoints not compacted yet
+    int num_new;            // endpoints appended since the last update
+
+    // open addressing set of pair keys, 0 is empty, 1 is deleted
+    uint64_t *pairs;
+    int pairs_capacity;     // power of two
+    int pair_count;
+    int pair_used;          // live plus deleted slots
+
+    // neighbor lists built from the pair set by updateSap
+    int *adj_start;
+    int *adj;
+    int adj_capacity;
+    int adj_proxies;        // proxies that existed when the lists were built
+};
+
+int initSap(struct Sap *s);
+
+// adds a proxy with the given bounds, returns its id
+int addSapProxy(struct Sap *s, float min_x, float min_y, float max_x, float max_y, void *user);
+
+// sets new bounds, takes effect on the next updateSap
+void moveSapProxy(struct Sap *s, int id, float min_x, float min_y, float max_x, float max_y);
+
+// drops the proxy and every pair it was part of
+void removeSapProxy(struct Sap *s, int id);
+
+// re-sorts the endpoints, updates the pair set and the neighbor lists
+void updateSap(struct Sap *s);
+
+// every proxy overlapping id as of the last updateSap
+int *getSapNeighbors(struct Sap *s, int id, int *count);
+
+void destroySap(struct Sap *s);
+
+#endif
@@ -0,0 +1,158 @@
+#include "sdf.h"
+
+#include <stdio.h>
+
+// ********** private functions **********
+
+// sample range touched by a box, clipped to the field
+static void sampleRange(struct Sdf *s, float min_x, float min_y, float max_x, float max_y,
+                        int *x0, int *y0, int *x1, int *y1) {
+    *x0 = (int)ceilf(min_x * s->inv_cell_size);
+    *y0 = (int)ceilf(min_y * s->inv_cell_size);
+    *x1 = (int)floorf(max_x * s->inv_cell_size);
+    *y1 = (int)floorf(max_y * s->inv_cell_size);
+    if(*x0 < 0) {
+        *x0 = 0;
+    }
+    if(*y0 < 0) {
+        *y0 = 0;
+    }
+    if(*x1 > s->width - 1) {
+        *x1 = s->width - 1;
+    }
+    if(*y1 > s->height - 1) {
+        *y1 = s->height - 1;
+    }
+}
+
+// keeps the closer of the stored sample and the new one
+static void mergeSample(struct Sdf *s, int i, float d, float gx, float gy) {
+    if(d < s->dist[i]) {
+        s->dist[i] = d;
+        s->grad_x[i] = gx;
+        s->grad_y[i] = gy;
+    }
+}
+
+// ********** public functions **********
+
+int initSdf(struct Sdf *s, float world_width, float world_height, float cell_size, float band) {
+    s->cell_size = cell_size;
+    s->inv_cell_size = 1.0f / cell_size;
+    s->band = band;
+    s->width = (int)ceilf(world_width / cell_size) + 1;
+    s->height = (int)ceilf(world_height / cell_size) + 1;
+
+    int n = s->width * s->height;
+    s->dist = malloc(n * sizeof(float));
+    s->grad_x = malloc(n * sizeof(float));
+    s->grad_y = malloc(n * sizeof(float));
+    if(s->dist == 0 || s->grad_x == 0 || s->grad_y == 0) {
+        printf("error allocating memory for sdf\n");
+        exit(1);
+    }
+
+    clearSdf(s, 0, 0, world_width, world_height);
+
+    return 0;
+}
+
+void clearSdf(struct Sdf *s, float min_x, float min_y, float max_x, float max_y) {
+    int x0, y0, x1, y1;
+    sampleRange(s, min_x, min_y, max_x, max_y, &x0, &y0, &x1, &y1);
+
+    for(int y = y0; y <= y1; y ++) {
+        for(int x = x0; x <= x1; x ++) {
+            int i = y * s->width + x;
+            s->dist[i] = s->band;
+            s->grad_x[i] = 0;
+            s->grad_y[i] = 0;
+        }
+    }
+}
+
+void addSdfCircle(struct Sdf *s, float cx, float cy, float radius) {
+    int x0, y0, x1, y1;
+    float reach = radius + s->band;
+    sampleRange(s, cx - reach, cy - reach, cx + reach, cy + reach, &x0, &y0, &x1, &y1);
+
+    for(int y = y0; y <= y1; y ++) {
+        for(int x = x0; x <= x1; x ++) {
+            float dx = x * s->cell_size - cx;
+            float dy = y * s->cell_size - cy;
+            float len = sqrtf(dx * dx + dy * dy);
+            if(len == 0) {
+                mergeSample(s, y * s->width + x, -radius, 1.0f, 0.0f);
+            }
+            else {
+                mergeSample(s, y * s->width + x, len - radius, dx / len, dy / len);
+            }
+        }
+    }
+}
+
+void addSdfRect(struct Sdf *s, float rx, float ry, float l, float h) {
+    int x0, y0, x1, y1;
+    sampleRange(s, rx - s->band, ry - s->band, rx + l + s->band, ry + h + s->band, &x0, &y0, &x1, &y1);
+
+    float half_l = l / 2, half_h = h / 2;
+    float cx = rx + half_l, cy = ry + half_h;
+
+    for(int y = y0; y <= y1; y ++) {
+        for(int x = x0; x <= x1; x ++) {
+            // distance past each half extent, negative when inside on that axis
+            float px = x * s->cell_size - cx;
+            float py = y * s->cell_size - cy;
+            float qx = fabsf(px) - half_l;
+            float qy = fabsf(py) - half_h;
+            float sx = px < 0 ? -1.0f : 1.0f;
+            float sy = py < 0 ? -1.0f : 1.0f;
+
+            if(qx > 0 || qy > 0) {
+                float ox = qx > 0 ? qx : 0;
+                float oy = qy > 0 ? qy : 0;
+                float len = sqrtf(ox * ox + oy * oy);
+                mergeSample(s, y * s->width + x, len, sx * ox / len, sy * oy / len);
+            }
+            // inside, the closest edge decides the gradient
+            else if(qx > qy) {
+                mergeSample(s, y * s->width + x, qx, sx, 0.0f);
+            }
+            else {
+                mergeSample(s, y * s->width + x, qy, 0.0f, sy);
+            }
+        }
+    }
+}
+
+int sampleSdf(struct Sdf *s, float x, float y, float *dist, float *grad_x, float *grad_y) {
+    float fx = x * s->inv_cell_size;
+    float fy = y * s->inv_cell_size;
+    int ix = (int)floorf(fx);
+    int iy = (int)floorf(fy);
+
+    if(ix < 0 || iy < 0 || ix >= s->width - 1 || iy >= s->height - 1) {
+        return 0;
+    }
+
+    float tx = fx - ix;
+    float ty = fy - iy;
+    float w00 = (1 - tx) * (1 - ty);
+    float w10 = tx * (1 - ty);
+    float w01 = (1 - tx) * ty;
+    float w11 = tx * ty;
+    int i = iy * s->width + ix;
+    int j = i + s->width;
+
+    *dist = s->dist[i] * w00 + s->dist[i + 1] * w10 + s->dist[j] * w01 + s->dist[j + 1] * w11;
+    *grad_x = s->grad_x[i] * w00 + s->grad_x[i + 1] * w10 + s->grad_x[j] * w01 + s->grad_x[j + 1] * w11;
+    *grad_y = s->grad_y[i] * w00 + s->grad_y[i + 1] * w10 + s->grad_y[j] * w01 + s->grad_y[j + 1] * w11;
+
+    return 1;
+}
+
+void destroySdf(struct Sdf *s) {
+    free(s->dist);
+    free(s->grad_x);
+    free(s->grad_y);
+}
@@ -0,0 +1,41 @@
+#ifndef SDF_H
+#define SDF_H
+
+#include <stdlib.h>
+#include <math.h>
+
+// Signed distance field sampled on a regular grid.
+// Each sample holds the distance to the closest shape (negative inside)
+// and the gradient of that distance, so a lookup gives both the depth and
+// the contact normal. Distances are clamped to +-band, which keeps adding
+// or removing a shape local to its bounds plus the band.
+struct Sdf {
+    int width;          // samples along x
+    int height;         // samples along y
+    float cell_size;
+    float inv_cell_size;
+    float band;
+
+    float *dist;
+    float *grad_x;
+    float *grad_y;
+};
+
+// covers world_width x world_height starting at the origin
+int initSdf(struct Sdf *s, float world_width, float world_height, float cell_size, float band);
+
+// resets every sample in the box to "nothing nearby"
+void clearSdf(struct Sdf *s, float min_x, float min_y, float max_x, float max_y);
+
+// merge a shape into the field
+// adding a shape that is already in the field changes nothing
+void addSdfCircle(struct Sdf *s, float x, float y, float radius);
+void addSdfRect(struct Sdf *s, float x, float y, float l, float h);
+
+// bilinear lookup of distance and gradient at x, y
+// returns 0 if the point is outside the field
+int sampleSdf(struct Sdf *s, float x, float y, float *dist, float *grad_x, float *grad_y);
+
+void destroySdf(struct Sdf *s);
+
+#endif
@@ -1,6 +1,47 @@
 
 #include "shader.h"
 
+//private, fills the uniform table from the linked program
+static void reflectUniforms(struct Shader *shdr) {
+    int32_t count;
+    glGetProgramiv(shdr->id, GL_ACTIVE_UNIFORMS, &count);
+
+    shdr->uniforms = malloc((count + 1) * sizeof(struct Uniform));
+    if(shdr->uniforms == NULL) {
+        printf("Error allocating uniform table\n");
+        exit(1);
+    }
+
+    shdr->num_uniforms = 0;
+    for(int i = 0; i < count; i ++) {
+        struct Uniform *u = &shdr->uniforms[shdr->num_uniforms];
+        int32_t size;
+        int32_t length;
+        glGetActiveUniform(shdr->id, i, UNIFORM_NAME_LENGTH, &length, &size, &u->type, u->name);
+
+        //arrays are reported as name[0], they are set by plain name too
+        if(length > 3 && strcmp(&u->name[length - 3], "[0]") == 0) {
+            u->name[length - 3] = '\0';
+        }
+
+        //members of uniform blocks have no location, the block is set as a whole
+        u->location = glGetUniformLocation(shdr->id, u->name);
+        if(u->location != -1) {
+            shdr->num_uniforms ++;
+        }
+    }
+}
+
+//private, entry for name, NULL if it has none
+static struct Uniform *findUniform(struct Shader *shdr, const char *name) {
+    for(int i = 0; i < shdr->num_uniforms; i ++) {
+        if(strcmp(shdr->uniforms[i].name, name) == 0) {
+            return &shdr->uniforms[i];
+        }
+    }
+    return NULL;
+}
+
 uint8_t initializeShader(struct Shader *shdr, const char *vertex_filename, const char *fragment_filename) {
     FILE *vertex_file;      //files to be read
     FILE *fragment_file;    //intellisense freaks out here but it is fine
@@ -12,6 +53,8 @@ uint8_t initializeShader(struct Shader *shdr, const char *vertex_filename, const
     char info_log[512];
     uint32_t file_size;
 
+    shdr->uniforms = NULL;
+    shdr->num_uniforms = 0;
     
     vertex_file = fopen(vertex_filename, "rb");
     fragment_file = fopen(fragment_filename, "rb");
@@ -91,6 +134,14 @@ uint8_t initializeShader(struct Shader *shdr, const char *vertex_filename, const
         return 0;
     }
 
+    reflectUniforms(shdr);
+
+    //shaders without the block just do not use the camera
+    uint32_t block = glGetUniformBlockIndex(shdr->id, CAMERA_BLOCK_NAME);
+    if(block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(shdr->id, block, CAMERA_BLOCK_BINDING);
+    }
+
     //vertex and fragment shaders deleted after linking to Shader program
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
@@ -108,18 +159,45 @@ uint8_t initializeShader(struct Shader *shdr, const char *vertex_filename, const
 
 void destroyShader(struct Shader *shdr) {
     glDeleteProgram(shdr->id);
+    free(shdr->uniforms);
+    shdr->uniforms = NULL;
+    shdr->num_uniforms = 0;
+}
+
+//private, location of name after checking it is one of the given types
+static int32_t getTypedLoc(struct Shader *shdr, const char *name, const uint32_t *types, int num_types) {
+    struct Uniform *u = findUniform(shdr, name);
+    if(u == NULL) {
+        printf("Error locating uniform %s\n", name);
+        exit(1);
+    }
+    for(int i = 0; i < num_types; i ++) {
+        if(u->type == types[i]) {
+            return u->location;
+        }
+    }
+    printf("Error uniform %s has type 0x%x\n", name, u->type);
+    exit(1);
+}
+
+struct UniformInt getUniformInt(struct Shader *shdr, const char *name) {
+    const uint32_t types[] = {GL_INT, GL_BOOL, GL_SAMPLER_2D, GL_SAMPLER_2D_ARRAY, GL_SAMPLER_CUBE};
+    return (struct UniformInt){getTypedLoc(shdr, name, types, 5)};
+}
+
+void setUniformInt(struct UniformInt u, int data) {
+    glUniform1i(u.location, data);
 }
 
 //private, only used to get location of uniform
-int32_t getUnifLoc(struct Shader *shdr, const char *name) {\
-    int32_t location;
-    location = glGetUniformLocation(shdr->id, name);
-    if(location == -1) {
+int32_t getUnifLoc(struct Shader *shdr, const char *name) {
+    struct Uniform *u = findUniform(shdr, name);
+    if(u == NULL) {
         printf("Error locating uniform %s\n", name);
         //maybe in the future don't just exit
         exit(1);
     }
-    return location;
+    return u->location;
 }
 
 void setInt(struct Shader *shdr, const char *name, int data) {
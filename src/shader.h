@@ -5,17 +5,50 @@
 #include <stdio.h>
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <glad/glad.h>
 
+//uniform blocks shared by every shader, each is bound to its binding point
+//at link time and fed from one buffer, see camera.h
+#define CAMERA_BLOCK_NAME "Camera"
+#define CAMERA_BLOCK_BINDING 0
+
+//longest uniform name kept, longer ones are cut short
+#define UNIFORM_NAME_LENGTH 64
+
+//one active uniform, as reflected from the program after linking
+struct Uniform {
+    char name[UNIFORM_NAME_LENGTH];
+    int32_t location;
+    uint32_t type;          //GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+};
+
 struct Shader {
     uint32_t id;
+
+    //every active uniform outside a uniform block
+    struct Uniform *uniforms;
+    int num_uniforms;
 };
 
+//typed handles to a uniform, looked up once and used without any string work
+//a handle of the wrong type for its uniform is caught when it is looked up
+//only the kinds something sets have one, add more the same way
+struct UniformInt { int32_t location; };        //also bools and samplers
+
 //returns 1 is successful, 0 if not
 uint8_t initializeShader(struct Shader *shdr, const char *vertex_filename, const char *fragment_filename);
 
 void destroyShader(struct Shader *shdr);
 
+//handle lookups, exit if the uniform is missing or of another type
+struct UniformInt getUniformInt(struct Shader *shdr, const char *name);
+
+//set through a handle, the shader has to be in use
+void setUniformInt(struct UniformInt u, int data);
+
+//set by name, a search of the uniform table on every call
+
 void setInt(struct Shader *shdr, const char *name, int data);
 
 void setFloat(struct Shader *shdr, const char *name, float data);
@@ -0,0 +1,55 @@
+#include "snapshot.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ********** public functions **********
+
+int initSnapshotBuffer(struct SnapshotBuffer *sb) {
+    memset(sb, 0, sizeof(*sb));
+    sb->write = 0;
+    sb->middle = 1;
+    sb->read = 2;
+    return 0;
+}
+
+struct SnapshotItem *addSnapshotItem(struct Snapshot *s) {
+    if(s->count >= s->capacity) {
+        int c = s->capacity == 0 ? 256 : s->capacity * 2;
+        struct SnapshotItem *temp = realloc(s->items, c * sizeof(struct SnapshotItem));
+        if(temp == 0) {
+            printf("error allocating memory for snapshot\n");
+            exit(1);
+        }
+        s->items = temp;
+        s->capacity = c;
+    }
+    return &s->items[s->count ++];
+}
+
+struct Snapshot *beginSnapshot(struct SnapshotBuffer *sb) {
+    struct Snapshot *s = &sb->slots[sb->write];
+    s->count = 0;
+    s->num_static = 0;
+    return s;
+}
+
+void publishSnapshot(struct SnapshotBuffer *sb) {
+    // the old middle slot is ours to write next, whether or not it was read
+    int old = __atomic_exchange_n(&sb->middle, sb->write | SNAPSHOT_FRESH, __ATOMIC_ACQ_REL);
+    sb->write = old & ~SNAPSHOT_FRESH;
+}
+
+struct Snapshot *latestSnapshot(struct SnapshotBuffer *sb) {
+    if(__atomic_load_n(&sb->middle, __ATOMIC_ACQUIRE) & SNAPSHOT_FRESH) {
+        int old = __atomic_exchange_n(&sb->middle, sb->read, __ATOMIC_ACQ_REL);
+        sb->read = old & ~SNAPSHOT_FRESH;
+    }
+    return &sb->slots[sb->read];
+}
+
+void destroySnapshotBuffer(struct SnapshotBuffer *sb) {
+    for(int i = 0; i < 3; i ++) {
+        free(sb->slots[i].items);
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdlib.h>
+
+// one sprite as it should be drawn, circles are given by their bounding box
+struct SnapshotItem {
+    float x;
+    float y;
+    float width;
+    float height;
+    float r;
+    float g;
+    float b;
+    int rect;               // 1 for rects, 0 for circles
+};
+
+// Everything the renderer needs from one simulation step.
+// Static geometry comes first so it can always be drawn in full.
+struct Snapshot {
+    struct SnapshotItem *items;
+    int count;
+    int num_static;
+    int capacity;
+};
+
+// Triple buffer handing snapshots from one writer thread to one reader thread.
+// The writer fills its slot and swaps it with the middle one, the reader
+// swaps the middle one for its own whenever something new is there.
+// Neither side ever waits, and the reader never sees a slot being written.
+struct SnapshotBuffer {
+    struct Snapshot slots[3];
+    int write;              // only used by the writer
+    int middle;             // slot index, SNAPSHOT_FRESH set when newly published
+    int read;               // only used by the reader
+};
+
+#define SNAPSHOT_FRESH 4
+
+int initSnapshotBuffer(struct SnapshotBuffer *sb);
+
+// makes room for one more item and returns it
+struct SnapshotItem *addSnapshotItem(struct Snapshot *s);
+
+// writer side, the returned snapshot is empty
+struct Snapshot *beginSnapshot(struct SnapshotBuffer *sb);
+void publishSnapshot(struct SnapshotBuffer *sb);
+
+// reader side, the latest published snapshot, empty until the first one
+// stays valid until the next call
+struct Snapshot *latestSnapshot(struct SnapshotBuffer *sb);
+
+void destroySnapshotBuffer(struct SnapshotBuffer *sb);
+
+#endif
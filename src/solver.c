@@ -0,0 +1,413 @@
+#include "solver.h"
+#include "const.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define min(x, y) (x < y ? x : y)
+
+// closing speeds below this do not bounce, so resting contacts stay put
+#define RESTITUTION_SLOP 20.0f
+
+// contacts per job index when a color is solved in parallel
+#define COLOR_CHUNK 128
+
+// share of the penetration removed each step, and how much is allowed
+#define CORRECTION_PERCENT 0.8f
+#define CORRECTION_SLOP 0.5f
+
+// ********** private functions **********
+
+static void *growArray(void *arr, int new_capacity, int elem_size) {
+    void *temp = realloc(arr, new_capacity * elem_size);
+    if(temp == 0) {
+        printf("error allocating memory for solver\n");
+        exit(1);
+    }
+    return temp;
+}
+
+static int hashKey(unsigned long long key, int capacity) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    return (int)(key & (unsigned long long)(capacity - 1));
+}
+
+// empties the cache and makes room for at least n entries
+static void resetCache(struct ContactCache *c, int n) {
+    int needed = 64;
+    while(needed < n * 2) {
+        needed *= 2;
+    }
+
+    if(needed > c->capacity) {
+        c->keys = growArray(c->keys, needed, sizeof(unsigned long long));
+        c->impulses = growArray(c->impulses, needed, sizeof(float));
+        c->capacity = needed;
+    }
+
+    memset(c->keys, 0, c->capacity * sizeof(unsigned long long));
+}
+
+static void insertCache(struct ContactCache *c, unsigned long long key, float impulse) {
+    int slot = hashKey(key, c->capacity);
+    while(c->keys[slot] != 0 && c->keys[slot] != key) {
+        slot = (slot + 1) & (c->capacity - 1);
+    }
+    c->keys[slot] = key;
+    c->impulses[slot] = impulse;
+}
+
+static float findCache(struct ContactCache *c, unsigned long long key) {
+    if(c->capacity == 0) {
+        return 0;
+    }
+
+    int slot = hashKey(key, c->capacity);
+    while(c->keys[slot] != 0) {
+        if(c->keys[slot] == key) {
+            return c->impulses[slot];
+        }
+        slot = (slot + 1) & (c->capacity - 1);
+    }
+    return 0;
+}
+
+// bodies without mass are never written, several colors may share them
+static void applyImpulse(struct Bodies *b, struct SolverContact *c, float impulse) {
+    float px = impulse * c->norm_x;
+    float py = impulse * c->norm_y;
+
+    if(b->inv_mass[c->a] != 0) {
+        b->vel_x[c->a] -= b->inv_mass[c->a] * px;
+        b->vel_y[c->a] -= b->inv_mass[c->a] * py;
+    }
+    if(c->b >= 0 && b->inv_mass[c->b] != 0) {
+        b->vel_x[c->b] += b->inv_mass[c->b] * px;
+        b->vel_y[c->b] += b->inv_mass[c->b] * py;
+    }
+}
+
+static float normalVelocity(struct Bodies *b, struct SolverContact *c) {
+    float rvx = -b->vel_x[c->a];
+    float rvy = -b->vel_y[c->a];
+    if(c->b >= 0) {
+        rvx += b->vel_x[c->b];
+        rvy += b->vel_y[c->b];
+    }
+    return rvx * c->norm_x + rvy * c->norm_y;
+}
+
+static void darken(struct Bodies *b, int i, float vel_norm) {
+    b->color_g[i] -= fabsf(vel_norm / DV);
+    b->color_b[i] -= fabsf(vel_norm / DV);
+    if(b->color_g[i] < 0) {
+        b->color_g[i] = 0;
+    }
+    if(b->color_b[i] < 0) {
+        b->color_b[i] = 0;
+    }
+}
+
+// works out the mass and target velocity of each contact from the
+// velocities it arrived with
+static void prepareContacts(struct Solver *s, struct Bodies *b) {
+    for(int k = 0; k < s->count; k ++) {
+        struct SolverContact *c = &s->contacts[k];
+        int static_b = c->b < 0;
+
+        float inv_mass = b->inv_mass[c->a] + (static_b ? 0 : b->inv_mass[c->b]);
+        c->mass = inv_mass > 0 ? 1.0f / inv_mass : 0;
+
+        float vel_norm = normalVelocity(b, c);
+        int explosive = b->explosive[c->a] || (!static_b && b->explosive[c->b]);
+        float boost = explosive ? EXPLOSIVE_SPEED : 0;
+
+        // same bounciness rules as collideCirc and collideCircVRect
+        float e = static_b ? min(b->restitution[c->a], 1.0f) : min(b->restitution[c->a], b->restitution[c->b]);
+
+        c->target = 0;
+        if(vel_norm - boost <= 0) {
+            if(vel_norm < -RESTITUTION_SLOP) {
+                c->target = -e * vel_norm;
+            }
+            c->target += (1 + e) * boost;
+
+            darken(b, c->a, vel_norm - boost);
+            if(!static_b) {
+                darken(b, c->b, vel_norm - boost);
+            }
+        }
+    }
+}
+
+static void warmContact(struct Solver *s, struct Bodies *b, struct SolverContact *c) {
+    c->impulse = findCache(&s->cache[s->current], c->key);
+    if(c->impulse != 0) {
+        applyImpulse(b, c, c->impulse);
+    }
+}
+
+static void solveContact(struct Bodies *b, struct SolverContact *c) {
+    float lambda = c->mass * (c->target - normalVelocity(b, c));
+
+    // contacts only push, so the total impulse never goes negative
+    float total = c->impulse + lambda;
+    if(total < 0) {
+        total = 0;
+    }
+    lambda = total - c->impulse;
+    c->impulse = total;
+
+    applyImpulse(b, c, lambda);
+}
+
+static void correctContact(struct Bodies *b, struct SolverContact *c) {
+    float depth = c->penetration - CORRECTION_SLOP;
+    if(depth <= 0 || c->mass == 0) {
+        return;
+    }
+
+    float corr = depth * c->mass * CORRECTION_PERCENT;
+    float cx = corr * c->norm_x;
+    float cy = corr * c->norm_y;
+
+    if(b->inv_mass[c->a] != 0) {
+        b->pos_x[c->a] -= b->inv_mass[c->a] * cx;
+        b->pos_y[c->a] -= b->inv_mass[c->a] * cy;
+    }
+    if(c->b >= 0 && b->inv_mass[c->b] != 0) {
+        b->pos_x[c->b] += b->inv_mass[c->b] * cx;
+        b->pos_y[c->b] += b->inv_mass[c->b] * cy;
+    }
+}
+
+// remembers this step's impulses for the next one
+static void storeImpulses(struct Solver *s) {
+    struct ContactCache *next = &s->cache[!s->current];
+
+    resetCache(next, s->count);
+    for(int k = 0; k < s->count; k ++) {
+        insertCache(next, s->contacts[k].key, s->contacts[k].impulse);
+    }
+    s->current = !s->current;
+}
+
+// greedy coloring in contact order, so the same contacts always get the
+// same colors
+static void colorContacts(struct Solver *s, struct Bodies *b) {
+    if(b->count > s->body_colors_capacity) {
+        s->body_colors_capacity = b->count * 2;
+        s->body_colors = growArray(s->body_colors, s->body_colors_capacity, sizeof(unsigned long long));
+    }
+    memset(s->body_colors, 0, b->count * sizeof(unsigned long long));
+
+    if(s->count > s->order_capacity) {
+        s->order_capacity = s->count * 2;
+        s->order = growArray(s->order, s->order_capacity, sizeof(int));
+    }
+
+    int counts[MAX_SOLVER_COLORS + 1];
+    memset(counts, 0, sizeof(counts));
+    s->num_colors = 0;
+
+    for(int k = 0; k < s->count; k ++) {
+        struct SolverContact *c = &s->contacts[k];
+        int move_a = b->inv_mass[c->a] != 0;
+        int move_b = c->b >= 0 && b->inv_mass[c->b] != 0;
+
+        unsigned long long used = 0;
+        if(move_a) {
+            used |= s->body_colors[c->a];
+        }
+        if(move_b) {
+            used |= s->body_colors[c->b];
+        }
+
+        // lowest free color, or the serial overflow color
+        int color = 0;
+        while(color < MAX_SOLVER_COLORS && (used >> color) & 1) {
+            color ++;
+        }
+        c->color = color;
+        counts[color] ++;
+
+        if(color < MAX_SOLVER_COLORS) {
+            if(move_a) {
+                s->body_colors[c->a] |= 1ull << color;
+            }
+            if(move_b) {
+                s->body_colors[c->b] |= 1ull << color;
+            }
+        }
+        if(color + 1 > s->num_colors) {
+            s->num_colors = color + 1;
+        }
+    }
+
+    s->color_start[0] = 0;
+    for(int color = 0; color < s->num_colors; color ++) {
+        s->color_start[color + 1] = s->color_start[color] + counts[color];
+    }
+
+    int fill[MAX_SOLVER_COLORS + 1];
+    memcpy(fill, s->color_start, sizeof(fill));
+    for(int k = 0; k < s->count; k ++) {
+        s->order[fill[s->contacts[k].color] ++] = k;
+    }
+}
+
+#define PASS_WARM 0
+#define PASS_VELOCITY 1
+#define PASS_POSITION 2
+
+// one color's worth of work for parallelFor
+struct ColorJob {
+    struct Solver *s;
+    struct Bodies *b;
+    int first;
+    int count;
+    int pass;
+};
+
+static void runColorChunk(void *arg, int index) {
+    struct ColorJob *job = arg;
+    int start = job->first + index * COLOR_CHUNK;
+    int end = start + COLOR_CHUNK;
+    if(end > job->first + job->count) {
+        end = job->first + job->count;
+    }
+
+    for(int k = start; k < end; k ++) {
+        struct SolverContact *c = &job->s->contacts[job->s->order[k]];
+        if(job->pass == PASS_WARM) {
+            warmContact(job->s, job->b, c);
+        }
+        else if(job->pass == PASS_VELOCITY) {
+            solveContact(job->b, c);
+        }
+        else {
+            correctContact(job->b, c);
+        }
+    }
+}
+
+// runs one pass over every color, colors one after another
+static void runColors(struct Solver *s, struct Bodies *b, struct Jobs *jobs, int width, int pass) {
+    for(int color = 0; color < s->num_colors; color ++) {
+        struct ColorJob job;
+        job.s = s;
+        job.b = b;
+        job.first = s->color_start[color];
+        job.count = s->color_start[color + 1] - job.first;
+        job.pass = pass;
+
+        int chunks = (job.count + COLOR_CHUNK - 1) / COLOR_CHUNK;
+
+        // the overflow color may share bodies, keep it on this thread
+        if(color == MAX_SOLVER_COLORS) {
+            for(int i = 0; i < chunks; i ++) {
+                runColorChunk(&job, i);
+            }
+        }
+        else {
+            parallelFor(jobs, width, runColorChunk, &job, chunks);
+        }
+    }
+}
+
+// ********** public functions **********
+
+int initSolver(struct Solver *s) {
+    memset(s, 0, sizeof(*s));
+    return 0;
+}
+
+void clearSolver(struct Solver *s) {
+    s->count = 0;
+}
+
+void addSolverContact(struct Solver *s, int a, int b, float norm_x, float norm_y, float penetration, unsigned long long key) {
+    if(s->count >= s->capacity) {
+        s->capacity = s->capacity == 0 ? 256 : s->capacity * 2;
+        s->contacts = growArray(s->contacts, s->capacity, sizeof(struct SolverContact));
+    }
+
+    struct SolverContact *c = &s->contacts[s->count ++];
+    c->a = a;
+    c->b = b;
+    c->norm_x = norm_x;
+    c->norm_y = norm_y;
+    c->penetration = penetration;
+    c->mass = 0;
+    c->target = 0;
+    c->impulse = 0;
+    c->key = key;
+}
+
+unsigned long long solverPairKey(int id_a, int id_b) {
+    // either order names the same pair
+    if(id_a > id_b) {
+        int temp = id_a;
+        id_a = id_b;
+        id_b = temp;
+    }
+    return (unsigned long long)id_a << 32 | (unsigned int)id_b;
+}
+
+unsigned long long solverStaticKey(int id_a, int static_id) {
+    return (unsigned long long)id_a << 32 | (STATIC_CONTACT_KEY | (unsigned int)static_id);
+}
+
+void solveVelocities(struct Solver *s, struct Bodies *b, int iterations) {
+    prepareContacts(s, b);
+
+    // warm start with what each pair needed last step
+    for(int k = 0; k < s->count; k ++) {
+        warmContact(s, b, &s->contacts[k]);
+    }
+
+    for(int it = 0; it < iterations; it ++) {
+        for(int k = 0; k < s->count; k ++) {
+            solveContact(b, &s->contacts[k]);
+        }
+    }
+
+    storeImpulses(s);
+}
+
+void solvePositions(struct Solver *s, struct Bodies *b) {
+    for(int k = 0; k < s->count; k ++) {
+        correctContact(b, &s->contacts[k]);
+    }
+}
+
+void solveVelocitiesColored(struct Solver *s, struct Bodies *b, int iterations, struct Jobs *jobs, int width) {
+    // touches both bodies' colors, so it stays serial
+    prepareContacts(s, b);
+    colorContacts(s, b);
+
+    runColors(s, b, jobs, width, PASS_WARM);
+    for(int it = 0; it < iterations; it ++) {
+        runColors(s, b, jobs, width, PASS_VELOCITY);
+    }
+
+    storeImpulses(s);
+}
+
+void solvePositionsColored(struct Solver *s, struct Bodies *b, struct Jobs *jobs, int width) {
+    runColors(s, b, jobs, width, PASS_POSITION);
+}
+
+void destroySolver(struct Solver *s) {
+    free(s->contacts);
+    free(s->cache[0].keys);
+    free(s->cache[0].impulses);
+    free(s->cache[1].keys);
+    free(s->cache[1].impulses);
+    free(s->order);
+    free(s->body_colors);
+    initSolver(s);
+}
@@ -0,0 +1,87 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <stdlib.h>
+
+#include "bodies.h"
+#include "jobs.h"
+
+// key for contacts against static geometry, b is a static id
+#define STATIC_CONTACT_KEY 0x80000000u
+
+// colors tracked per body, contacts past this go in one extra serial color
+#define MAX_SOLVER_COLORS 64
+
+// One contact waiting to be solved.
+// b is -1 when the contact is against static geometry.
+struct SolverContact {
+    int a;
+    int b;
+    float norm_x;           // from a towards b
+    float norm_y;
+    float penetration;
+    float mass;             // inverse of the summed inverse masses
+    float target;           // normal velocity the solver drives towards
+    float impulse;          // accumulated normal impulse
+    unsigned long long key;
+    int color;
+};
+
+// accumulated impulses by pair key, open addressing, 0 marks an empty slot
+struct ContactCache {
+    unsigned long long *keys;
+    float *impulses;
+    int capacity;           // always a power of two
+};
+
+// Sequential impulse solver with warm starting.
+// Contacts are gathered for a whole step, then solved together. The
+// impulse each pair ends a step with is remembered and applied up front
+// the next step, so resting contacts start close to their answer.
+struct Solver {
+    struct SolverContact *contacts;
+    int count;
+    int capacity;
+
+    // last step's impulses are read from cache[current], this step's
+    // go into the other one
+    struct ContactCache cache[2];
+    int current;
+
+    // contacts grouped by color, no two contacts in a color share a
+    // moving body, so a color can be solved in any order or in parallel
+    int *order;                 // contact indices, color by color
+    int order_capacity;
+    int color_start[MAX_SOLVER_COLORS + 2];
+    int num_colors;
+    unsigned long long *body_colors;    // colors each body is in, one bit per color
+    int body_colors_capacity;
+};
+
+int initSolver(struct Solver *s);
+
+// forgets this step's contacts, the cache is kept
+void clearSolver(struct Solver *s);
+
+// key must not change while the pair stays in contact
+// use solverPairKey for two bodies, or solverStaticKey for static geometry
+void addSolverContact(struct Solver *s, int a, int b, float norm_x, float norm_y, float penetration, unsigned long long key);
+unsigned long long solverPairKey(int id_a, int id_b);
+unsigned long long solverStaticKey(int id_a, int static_id);
+
+// warm starts and runs iterations passes over the contacts, changing
+// only velocities, then remembers the impulses for the next step
+void solveVelocities(struct Solver *s, struct Bodies *b, int iterations);
+
+// pushes bodies apart by most of their remaining penetration
+void solvePositions(struct Solver *s, struct Bodies *b);
+
+// same as the two above, but each color is split across up to width jobs
+// static geometry and bodies without mass never constrain the coloring
+// the result does not depend on the number of threads
+void solveVelocitiesColored(struct Solver *s, struct Bodies *b, int iterations, struct Jobs *jobs, int width);
+void solvePositionsColored(struct Solver *s, struct Bodies *b, struct Jobs *jobs, int width);
+
+void destroySolver(struct Solver *s);
+
+#endif
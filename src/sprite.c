@@ -3,8 +3,45 @@
 
 #define FPV 4
 
-void initSpriteRenderer(struct SpriteRenderer *sprite) {
-    unsigned int VBO, VAO;
+// points the instance attributes at instance base onwards
+// the sprite VAO has to be bound
+static void pointInstances(void *arg, int base) {
+    struct SpriteRenderer *sprite = arg;
+    size_t offset = base * sizeof(struct SpriteInstance);
+
+    glBindBuffer(GL_ARRAY_BUFFER, sprite->instance_VBO);
+    // 4 floats for position and size
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(struct SpriteInstance), (void*)offset);
+    // 1 float for rotation
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(struct SpriteInstance), (void*)(offset + 4 * sizeof(float)));
+    // 3 floats for color
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(struct SpriteInstance), (void*)(offset + 5 * sizeof(float)));
+    // 4 floats for the texture rect
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(struct SpriteInstance), (void*)(offset + 8 * sizeof(float)));
+}
+
+// turns the batch being collected into a draw command
+static void endBatch(struct SpriteRenderer *sprite) {
+    if(sprite->count == sprite->batch_start) {
+        return;
+    }
+
+    struct DrawCommand *cmd = pushDrawCommand(sprite->queue);
+    cmd->key = drawKey(sprite->shader->id, sprite->texture_id, sprite->VAO, sprite->num_batches ++);
+    cmd->program = sprite->shader->id;
+    cmd->texture = sprite->texture_id;
+    cmd->VAO = sprite->VAO;
+    cmd->vertices = 6;
+    cmd->base = sprite->batch_start;
+    cmd->instances = sprite->count - sprite->batch_start;
+    cmd->prepare = pointInstances;
+    cmd->arg = sprite;
+
+    sprite->batch_start = sprite->count;
+}
+
+void initSpriteRenderer(struct SpriteRenderer *sprite, struct RenderQueue *queue) {
+    unsigned int VBO, VAO, instance_VBO;
     // 6 vertices with 4 floats per vertex
     float verts[] = {
         0.0, 1.0, 0.0, 1.0,
@@ -16,6 +53,7 @@ void initSpriteRenderer(struct SpriteRenderer *sprite) {
     };
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
+    glGenBuffers(1, &instance_VBO);
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
@@ -29,32 +67,99 @@ void initSpriteRenderer(struct SpriteRenderer *sprite) {
     glEnableVertexAttribArray(1);
 
     sprite->VAO = VAO;
+    sprite->VBO = VBO;
+    sprite->instance_VBO = instance_VBO;
+    sprite->instance_VBO_size = 0;
+    sprite->queue = queue;
+    sprite->instances = 0;
+    sprite->count = 0;
+    sprite->capacity = 0;
+    sprite->batch_start = 0;
+    sprite->num_batches = 0;
+    sprite->shader = 0;
+    sprite->texture_id = 0;
+
+    // instance buffer attributes, advancing once per sprite
+    pointInstances(sprite, 0);
+    for(int i = 2; i <= 5; i ++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+
+    glBindVertexArray(0);
 
     return;
 }
 
-void drawSprite(struct SpriteRenderer *sprite, struct Shader *shader, 
-                int texture_id, vec2 position, vec2 size, float rotation, vec3 color) {
-    // bind the texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+struct SpriteInstance *addSprite(struct SpriteRenderer *sprite, struct Shader *shader, struct TextureRegion *texture) {
+    // anything else starts a new batch, textures on the same page share one
+    if(shader != sprite->shader || texture->id != sprite->texture_id) {
+        endBatch(sprite);
+    }
+    sprite->shader = shader;
+    sprite->texture_id = texture->id;
+
+    if(sprite->count >= sprite->capacity) {
+        int c = sprite->capacity == 0 ? 256 : sprite->capacity * 2;
+        struct SpriteInstance *temp = realloc(sprite->instances, c * sizeof(struct SpriteInstance));
+        if(temp == 0) {
+            printf("error allocating memory for sprites\n");
+            exit(1);
+        }
+        sprite->instances = temp;
+        sprite->capacity = c;
+    }
+
+    struct SpriteInstance *s = &sprite->instances[sprite->count ++];
+    s->u = texture->u;
+    s->v = texture->v;
+    s->uv_width = texture->width;
+    s->uv_height = texture->height;
+    return s;
+}
 
-    glUseProgram(shader->id);
-    glBindVertexArray(sprite->VAO);
+void drawSprite(struct SpriteRenderer *sprite, struct Shader *shader, 
+                struct TextureRegion *texture, vec2 position, vec2 size, float rotation, vec3 color) {
+    struct SpriteInstance *s = addSprite(sprite, shader, texture);
+    s->x = position[0];
+    s->y = position[1];
+    s->width = size[0];
+    s->height = size[1];
+    s->rotation = rotation;
+    s->r = color[0];
+    s->g = color[1];
+    s->b = color[2];
 
-    mat4 model;
+    return;
+}
 
-    glm_translate_make(model, (vec3){position[0], position[1], 0.0});
-    glm_translate(model, (vec3){0.5 * size[0], 0.5 * size[1], 0.0});
-    glm_rotate(model, rotation, (vec3){0.0, 0.0, 1.0});
-    glm_translate(model, (vec3){-0.5 * size[0], -0.5 * size[1], 0.0});
-    glm_scale(model, (vec3){size[0], size[1], 1.0});
+void flushSprites(struct SpriteRenderer *sprite) {
+    endBatch(sprite);
+    if(sprite->count == 0) {
+        return;
+    }
 
-    setMat4(shader, "model", model);
-    setVec3(shader, "sprite_color", color);
+    // orphan last frame's storage instead of waiting for it to be drawn
+    glBindBuffer(GL_ARRAY_BUFFER, sprite->instance_VBO);
+    if(sprite->count > sprite->instance_VBO_size) {
+        sprite->instance_VBO_size = sprite->capacity;
+    }
+    glBufferData(GL_ARRAY_BUFFER, sprite->instance_VBO_size * sizeof(struct SpriteInstance), 0, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sprite->count * sizeof(struct SpriteInstance), sprite->instances);
 
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    sprite->count = 0;
+    sprite->batch_start = 0;
+    sprite->num_batches = 0;
 
     return;
 }
 
+void destroySpriteRenderer(struct SpriteRenderer *sprite) {
+    glDeleteVertexArrays(1, &sprite->VAO);
+    glDeleteBuffers(1, &sprite->VBO);
+    glDeleteBuffers(1, &sprite->instance_VBO);
+    free(sprite->instances);
+    sprite->instances = 0;
+    sprite->count = 0;
+    sprite->capacity = 0;
+}
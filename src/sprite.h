@@ -6,14 +6,61 @@
 
 #include "texman.h"
 #include "shader.h"
+#include "render.h"
 
+// everything that differs between two sprites of one batch
+struct SpriteInstance {
+    float x;                // top left corner
+    float y;
+    float width;
+    float height;
+    float rotation;         // radians about the center
+    float r;
+    float g;
+    float b;
+    float u;                // rect of the texture region, see texman.h
+    float v;
+    float uv_width;
+    float uv_height;
+};
+
+// Collects sprites into batches, each becomes one instanced draw command.
+// A batch is all the sprites queued in a row with the same shader and atlas page.
+// Every instance of a frame goes up in one upload, commands draw their part.
 struct SpriteRenderer {
     unsigned int VAO;
+    unsigned int VBO;
+    unsigned int instance_VBO;
+    int instance_VBO_size;  // in instances
+    struct RenderQueue *queue;
+
+    // everything queued since the last flush
+    struct SpriteInstance *instances;
+    int count;
+    int capacity;
+
+    // the batch being collected
+    int batch_start;
+    int num_batches;
+    struct Shader *shader;
+    unsigned int texture_id;   // page of the batch
 };
 
-void initSpriteRenderer(struct SpriteRenderer *sprite);
+// batches are pushed to queue as draw commands
+void initSpriteRenderer(struct SpriteRenderer *sprite, struct RenderQueue *queue);
 
+// queues a sprite, drawn once the queue is submitted after a flush
 void drawSprite(struct SpriteRenderer *sprite, struct Shader *shader, 
-                int texture_id, vec2 position, vec2 size, float rotation, vec3 color);
+                struct TextureRegion *texture, vec2 position, vec2 size, float rotation, vec3 color);
+
+// same as drawSprite, returns the instance for the caller to fill in
+// the texture rect is already filled in
+struct SpriteInstance *addSprite(struct SpriteRenderer *sprite, struct Shader *shader, struct TextureRegion *texture);
+
+// ends the last batch and uploads every instance queued so far
+// the queue has to be submitted before the next flush replaces them
+void flushSprites(struct SpriteRenderer *sprite);
+
+void destroySpriteRenderer(struct SpriteRenderer *sprite);
 
-#endif
\ No newline at end of file
+#endif
@@ -1,40 +1,206 @@
-
 #include "texman.h"
 
 // ********** private functions **********
 
-int loadTexture(char *name) {
+// loads textures/name.png as rgba, NULL if it cannot be
+unsigned char *loadImage(char *name, int *width, int *height) {
     // create name path
     // e.g. textures/name.png
     int name_len = strlen(name);
     char *texname = malloc(name_len + 20);
-    texname[name_len] = '\0';
-    strcpy(texname, "textures/\0");
+    if(texname == 0) {
+        printf("error allocating memory for texture name\n");
+        exit(1);
+    }
+    strcpy(texname, "textures/");
     strcat(texname, name);
-    strcat(texname, ".png\0");
+    strcat(texname, ".png");
+
+    int nr_channels;
+    unsigned char *image_data = stbi_load(texname, width, height, &nr_channels, STBI_rgb_alpha);
+    if(image_data == NULL) {
+        printf("Failed to load texture %s\n", texname);
+    }
 
-    unsigned char *image_data;
-    int image_width, image_height, nr_channels;
-    unsigned int texture;
+    free(texname);
 
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    return image_data;
+}
+
+// smallest power of two that is at least n
+int nextPowerOfTwo(int n) {
+    int p = 1;
+    while(p < n) {
+        p *= 2;
+    }
+    return p;
+}
+
+// an empty width by height texture for a page
+unsigned int createPageTexture(int width, int height) {
+    unsigned int id;
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    image_data = stbi_load(texname, &image_width, &image_height, &nr_channels, STBI_rgb_alpha);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+    return id;
+}
+
+struct AtlasPage *addPage(struct TexMan *texman, int width, int height) {
+    if(texman->num_pages >= texman->pages_capacity) {
+        texman->pages_capacity = texman->pages_capacity == 0 ? 4 : texman->pages_capacity * 2;
+        struct AtlasPage *temp = realloc(texman->pages, texman->pages_capacity * sizeof(struct AtlasPage));
+        if(temp == 0) {
+            printf("error allocating memory for atlas pages\n");
+            exit(1);
+        }
+        texman->pages = temp;
+    }
+
+    struct AtlasPage *page = &texman->pages[texman->num_pages ++];
+    page->id = createPageTexture(width, height);
+    page->width = width;
+    page->height = height;
+    page->shelf_x = 0;
+    page->shelf_y = 0;
+    page->shelf_height = 0;
+
+    return page;
+}
+
+// finds room for a width by height rect on page, 0 if there is none
+// page is left alone unless the rect fits
+int placeOnPage(struct AtlasPage *page, int width, int height, int *x, int *y) {
+    int shelf_x = page->shelf_x;
+    int shelf_y = page->shelf_y;
+    int shelf_height = page->shelf_height;
+
+    // start a new shelf if the open one is out of room
+    if(shelf_x + width > page->width) {
+        shelf_y += shelf_height;
+        shelf_x = 0;
+        shelf_height = 0;
+    }
+    if(shelf_x + width > page->width || shelf_y + height > page->height) {
+        return 0;
+    }
+
+    *x = shelf_x;
+    *y = shelf_y;
+    page->shelf_x = shelf_x + width;
+    page->shelf_y = shelf_y;
+    page->shelf_height = height > shelf_height ? height : shelf_height;
+    return 1;
+}
+
+// texture coordinates of tex from where it is on its page
+void setRegion(struct TexMan *texman, struct Texture *tex) {
+    struct AtlasPage *page = &texman->pages[tex->page];
+    tex->region.id = page->id;
+    tex->region.u = (tex->x + 0.5f) / page->width;
+    tex->region.v = (tex->y + 0.5f) / page->height;
+    tex->region.width = (tex->width - 1.0f) / page->width;
+    tex->region.height = (tex->height - 1.0f) / page->height;
+}
+
+// moves page index into a new width by height texture, keeping what is on it
+void resizePage(struct TexMan *texman, int index, int width, int height) {
+    struct AtlasPage *page = &texman->pages[index];
+    unsigned int id = createPageTexture(width, height);
+
+    // gl 3.3 has no texture to texture copy, blit between framebuffers instead
+    unsigned int fbos[2];
+    glGenFramebuffers(2, fbos);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[0]);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, page->id, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[1]);
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, id, 0);
+    glBlitFramebuffer(0, 0, page->width, page->height, 0, 0, page->width, page->height,
+                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(2, fbos);
+    glDeleteTextures(1, &page->id);
+
+    page->id = id;
+    page->width = width;
+    page->height = height;
+
+    // everything already on it has new texture coordinates
+    for(struct Texture *current = texman->head; current != 0; current = current->next) {
+        if(current->page == index) {
+            setRegion(texman, current);
+        }
+    }
+}
+
+// doubles the narrower side of page index until a width by height rect fits,
+// up to ATLAS_PAGE_SIZE, returns 0 and leaves the page alone if it never does
+int growPage(struct TexMan *texman, int index, int width, int height, int *x, int *y) {
+    struct AtlasPage grown = texman->pages[index];
+    while(grown.width < ATLAS_PAGE_SIZE || grown.height < ATLAS_PAGE_SIZE) {
+        if(grown.width <= grown.height && grown.width < ATLAS_PAGE_SIZE) {
+            grown.width *= 2;
+        }
+        else {
+            grown.height *= 2;
+        }
+
+        if(placeOnPage(&grown, width, height, x, y)) {
+            resizePage(texman, index, grown.width, grown.height);
+            grown.id = texman->pages[index].id;
+            texman->pages[index] = grown;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// packs name's image into the first page with room, growing a page or
+// adding one if none has any
+int loadTexture(struct TexMan *texman, char *name, struct Texture *tex) {
+    int width, height;
+    unsigned char *image_data = loadImage(name, &width, &height);
     if(image_data == NULL) {
-        printf("Failed to load texture %s\n", texname);
         return -1;
     }
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_width, image_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
-    glGenerateMipmap(GL_TEXTURE_2D);
+
+    int padded_width = width + 2 * ATLAS_PADDING;
+    int padded_height = height + 2 * ATLAS_PADDING;
+    int index = -1;
+    int x, y;
+    for(int i = 0; i < texman->num_pages && index < 0; i ++) {
+        if(placeOnPage(&texman->pages[i], padded_width, padded_height, &x, &y)) {
+            index = i;
+        }
+    }
+    for(int i = 0; i < texman->num_pages && index < 0; i ++) {
+        if(growPage(texman, i, padded_width, padded_height, &x, &y)) {
+            index = i;
+        }
+    }
+    if(index < 0) {
+        struct AtlasPage *page = addPage(texman, nextPowerOfTwo(padded_width), nextPowerOfTwo(padded_height));
+        placeOnPage(page, padded_width, padded_height, &x, &y);
+        index = texman->num_pages - 1;
+    }
+
+    tex->page = index;
+    tex->x = x + ATLAS_PADDING;
+    tex->y = y + ATLAS_PADDING;
+    tex->width = width;
+    tex->height = height;
+
+    glBindTexture(GL_TEXTURE_2D, texman->pages[index].id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, tex->x, tex->y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
     stbi_image_free(image_data);
-    
-    free(texname);
 
-    return texture;
+    setRegion(texman, tex);
+
+    return 0;
 }
 
 int appendTexture(struct TexMan *texman, char *name) {
@@ -48,9 +214,8 @@ int appendTexture(struct TexMan *texman, char *name) {
     // init texture struct variables
     newtex->name = malloc(strlen(name) + 1);
     strcpy(newtex->name, name);
-    newtex->id = loadTexture(name);
 
-    if(newtex->id == -1) {
+    if(loadTexture(texman, name, newtex) == -1) {
         free(newtex->name);
         free(newtex);
         return -1;
@@ -72,7 +237,7 @@ int appendTexture(struct TexMan *texman, char *name) {
 
 // ********** public functions **********
 
-int getTextureId(struct TexMan *texman, char *name) {
+struct TextureRegion *getTextureRegion(struct TexMan *texman, char *name) {
     uint8_t found = 0;
     struct Texture *current = texman->head;
     // check if the texture has already been loaded
@@ -86,19 +251,22 @@ int getTextureId(struct TexMan *texman, char *name) {
 
     // load texture if it has not been loaded
     if(!found) {
-        // Attempt to load texture. If it cannot be loaded, return -1
+        // Attempt to load texture. If it cannot be loaded, return NULL
         if(appendTexture(texman, name) == -1) {
-            return -1;
+            return NULL;
         }
         current = texman->tail;
     }
 
-    return current->id;
+    return &current->region;
 }
 
 void initTexMan(struct TexMan *texman) {
     texman->head = 0;
     texman->tail = 0;
+    texman->pages = 0;
+    texman->num_pages = 0;
+    texman->pages_capacity = 0;
 }
 
 void destroyTexMan(struct TexMan *texman) {
@@ -109,5 +277,10 @@ void destroyTexMan(struct TexMan *texman) {
         current = current->next;
         free(temp);
     }
-}
 
+    for(int i = 0; i < texman->num_pages; i ++) {
+        glDeleteTextures(1, &texman->pages[i].id);
+    }
+    free(texman->pages);
+    initTexMan(texman);
+}
@@ -9,24 +9,66 @@
 #include <stb_image.h>
 #include <glad/glad.h>
 
+// largest width and height a page grows to, images too big for one get a page of their own
+#define ATLAS_PAGE_SIZE 4096
+
+// empty texels kept around every image in a page
+#define ATLAS_PADDING 2
+
+// Where one loaded image ended up, everything a sprite needs to draw it.
+// The rect is in texture coordinates of the page, inset by half a texel
+// so nearest sampling never reaches the padding.
+struct TextureRegion {
+    unsigned int id;        // gl texture of the page
+    float u;
+    float v;
+    float width;
+    float height;
+};
+
 // single linked list of textures
 struct Texture {
     struct Texture *next;
-    unsigned int id;
+    struct TextureRegion region;
     char *name;
+
+    // where the image is in texels, to redo region when its page grows
+    int page;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// One gl texture that images are packed into, shelf by shelf.
+// Images go left to right along the open shelf, when one does not fit
+// a new shelf starts on top of the tallest image of the last one.
+// A page starts at the smallest power of two sizes that fit its first image
+// and doubles its width or height when the next one does not fit.
+struct AtlasPage {
+    unsigned int id;
+    int width;
+    int height;
+    int shelf_x;
+    int shelf_y;
+    int shelf_height;
 };
 
 struct TexMan {
     struct Texture *head;
     struct Texture *tail;
+
+    struct AtlasPage *pages;
+    int num_pages;
+    int pages_capacity;
 };
 
 void initTexMan(struct TexMan *texman);
 
-// Searches for texture in list of textures and returns id
-// if texture attempts to load texture
-// if texture cannot be loaded, returns -1
-int getTextureId(struct TexMan *texman, char *name);
+// Searches for texture in list of textures and returns its region
+// if texture attempts to load texture and packs it into a page
+// if texture cannot be loaded, returns NULL
+struct TextureRegion *getTextureRegion(struct TexMan *texman, char *name);
 
 void destroyTexMan(struct TexMan *texman);
 
@@ -0,0 +1,62 @@
+#include "timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+static uint64_t start_ticks = 0;
+static uint64_t frame_ticks = 0;
+
+#ifdef _WIN32
+static uint64_t frequency = 0;
+#endif
+
+// ********** private functions **********
+
+// nanoseconds from some fixed point in the past
+static uint64_t readClock() {
+#ifdef _WIN32
+    LARGE_INTEGER count;
+    if(frequency == 0) {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        frequency = f.QuadPart;
+    }
+    QueryPerformanceCounter(&count);
+
+    // split so count * TICKS_PER_SECOND can't overflow
+    uint64_t c = count.QuadPart;
+    return c / frequency * TICKS_PER_SECOND + c % frequency * TICKS_PER_SECOND / frequency;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * TICKS_PER_SECOND + t.tv_nsec;
+#endif
+}
+
+// ********** public functions **********
+
+int initTimer() {
+    start_ticks = readClock();
+    return 0;
+}
+
+uint64_t getTicks() {
+    return readClock() - start_ticks;
+}
+
+uint64_t updateFrameTicks() {
+    uint64_t now = getTicks();
+
+    // two threads may race here, never let the cached time go backwards
+    uint64_t old = __atomic_load_n(&frame_ticks, __ATOMIC_RELAXED);
+    while(now > old && !__atomic_compare_exchange_n(&frame_ticks, &old, now, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return now;
+}
+
+uint64_t getFrameTicks() {
+    uint64_t t = __atomic_load_n(&frame_ticks, __ATOMIC_RELAXED);
+    return t == 0 ? getTicks() : t;
+}
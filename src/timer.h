@@ -0,0 +1,29 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+// Monotonic clock in 64 bit ticks of one nanosecond, counted from initTimer.
+// Store points in time as ticks, differences of them as float seconds
+// are only for durations, which stay small.
+#define TICKS_PER_SECOND 1000000000ULL
+
+// t is a difference of two tick counts, negative if it wrapped below 0
+#define ticksToSeconds(t) ((double)(int64_t)(t) / TICKS_PER_SECOND)
+#define secondsToTicks(s) ((uint64_t)((s) * TICKS_PER_SECOND))
+
+// call once before anything else reads the clock
+int initTimer();
+
+// reads the clock
+uint64_t getTicks();
+
+// Hot paths that only need to know roughly when they are, like spawning or
+// debouncing keys, use the time cached once per frame instead of the clock.
+// Whoever steps the world refreshes it at the start of each frame or step.
+// returns the new time
+uint64_t updateFrameTicks();
+// the last updateFrameTicks, or the clock if it was never called
+uint64_t getFrameTicks();
+
+#endif